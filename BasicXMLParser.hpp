@@ -0,0 +1,2029 @@
+/*
+    BasicXMLParser.hpp
+
+    Declaration and implementation of the XML parsing class template.
+    Events are delivered by calling the member functions of the Handler
+    directly. Any event the Handler does not declare is not dispatched,
+    and its call compiles away:
+
+        void handleDeclaration(std::string_view version, std::string_view encoding, std::string_view standalone);
+        void handleStartTag(std::string_view local_name, std::string_view prefix);
+        void handleEndTag(std::string_view local_name, std::string_view prefix);
+        void handleAttribute(std::string_view local_name, std::string_view value);
+        void handleNamespace(std::string_view uri, std::string_view prefix);
+        void handleCDATA(std::string_view characters);
+        void handleEntity(std::string_view characters);
+        void handleCharacters(std::string_view characters);
+        void handleComments(std::string_view comment);
+
+    All views are into the parse buffer, and are only valid for the
+    duration of the call.
+
+    Each reference in content is an entity event with its UTF-8
+    characters, for the predefined entities and character references.
+    Attribute values are not decoded, since most have no references.
+    A handler that needs the decoded value calls decodeXMLText(), see
+    xmlEntities.hpp.
+
+    Instead of the name-only forms, a Handler may declare forms that
+    also take the ID of the qualified name in the parser's name table:
+
+        void handleStartTag(int id, std::string_view local_name, std::string_view prefix);
+        void handleEndTag(int id, std::string_view local_name, std::string_view prefix);
+        void handleAttribute(int id, std::string_view local_name, std::string_view value);
+
+    IDs are stable for the lifetime of the parser, so a Handler can
+    classify a name once and then switch on or index by its ID.
+
+    A Handler may instead take each start tag with all of its attributes
+    and namespace declarations in one event, see XMLAttributes.hpp:
+
+        void handleStartTag(std::string_view local_name, std::string_view prefix, const XMLAttributes& attributes);
+        void handleStartTag(int id, std::string_view local_name, std::string_view prefix, const XMLAttributes& attributes);
+
+    The whole tag is then parsed in one step, and there are no separate
+    attribute or namespace events. With the ID form, each attribute has
+    the ID of its qualified name.
+
+    A Handler that declares the form with a namespace ID has the names
+    resolved, see XMLNamespaceResolver.hpp, and each attribute also has
+    its namespace ID:
+
+        void handleStartTag(int id, int namespaceId, std::string_view local_name, std::string_view prefix, const XMLAttributes& attributes);
+        void handleEndTag(int id, int namespaceId, std::string_view local_name, std::string_view prefix);
+
+    A namespace ID is the ID of the uri in names(), or -1 for none. A
+    fragment has only the namespaces it declares.
+
+    A Handler may instead take characters and CDATA with the number of
+    newlines in them, counted in the scan for the end of the characters,
+    so the handler need not count them in another pass:
+
+        void handleCharacters(std::string_view characters, long newlines);
+        void handleCDATA(std::string_view characters, long newlines);
+
+    With countText(), the parser also keeps totals of the bytes and
+    newlines of text, characters, CDATA, and entities, for any handler.
+
+    A Handler that only counts an event may declare it with no
+    parameters, e.g., void handleStartTag(). The parser then only
+    scans past the payload of the event, e.g., with no name split.
+    With no names and no attributes or namespaces used, a start tag
+    is skipped to its '>' in one scan.
+
+    Any handler may return an XMLControl instead of void:
+    * Continue parsing
+    * SkipSubtree, the rest of the current element. For a start tag,
+      attribute, or namespace this is the element of the start tag.
+      The rest is found by a depth-counting scan with no events, and
+      parsing resumes with the end tag of the element.
+    * Stop parsing, and return from parse()
+
+    With checkWellFormed(), the parser checks that end tags match their
+    start tags, that a start tag has no duplicate attributes, and that
+    names start with a name start character and have only name
+    characters. A document must have a single root element that is
+    closed at the end of input. A fragment may end elements it did not
+    start, e.g., the root of an archive.
+
+    A Handler that declares an error event is given each parse error,
+    with its kind and byte offset, see XMLError.hpp:
+
+        void handleError(const XMLError& error);
+
+    Parsing then resumes at the next top-level unit, the next start tag
+    with the name of the last element started at depth 1, or if there
+    is none, the rest of the input is skipped. The elements the error
+    leaves open are first ended with end events, so each delivered start
+    tag has an end tag. Elements a fragment started inside are not
+    ended. The handler may instead return XMLControl::Stop. Without it,
+    the parser reports the error with its line and column, and exits.
+    Corrupt or truncated compressed input is an error of kind
+    XMLErrorKind::Compression, at the end of the input decompressed
+    before it, and the rest of the input is skipped.
+
+    Built with XML_PARSER_STATS, stats() has the count, time, and bytes
+    of each kind of parse step, and the refills. See XMLParserStats.hpp.
+*/
+
+#ifndef INCLUDED_BASICXMLPARSER_HPP
+#define INCLUDED_BASICXMLPARSER_HPP
+
+#include "ReadAhead.hpp"
+#include "MappedFile.hpp"
+#include "xmlScan.hpp"
+#include "XMLNameTable.hpp"
+#include "xmlChars.hpp"
+#include "xmlEntities.hpp"
+#include "XMLAttributes.hpp"
+#include "XMLNamespaceResolver.hpp"
+#include "XMLParserStats.hpp"
+#include "XMLError.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <type_traits>
+#include <utility>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+// inline the parse step into the parse loops, including those of callers
+#if defined(_MSC_VER)
+#define XML_PARSER_INLINE __forceinline
+#else
+#define XML_PARSER_INLINE inline __attribute__((always_inline))
+#endif
+
+// control code a handler may return
+enum class XMLControl {
+    Continue,
+    SkipSubtree,
+    Stop
+};
+
+namespace xml_detail {
+
+    // detect if Op<Handler> is well-formed
+    template <typename Handler, template <typename> class Op, typename = void>
+    struct detect : std::false_type {};
+
+    template <typename Handler, template <typename> class Op>
+    struct detect<Handler, Op, std::void_t<Op<Handler>>> : std::true_type {};
+
+    template <typename Handler>
+    using declarationEvent = decltype(std::declval<Handler&>().handleDeclaration(std::string_view(), std::string_view(), std::string_view()));
+
+    template <typename Handler>
+    using startTagEvent = decltype(std::declval<Handler&>().handleStartTag(std::string_view(), std::string_view()));
+
+    template <typename Handler>
+    using endTagEvent = decltype(std::declval<Handler&>().handleEndTag(std::string_view(), std::string_view()));
+
+    template <typename Handler>
+    using attributeEvent = decltype(std::declval<Handler&>().handleAttribute(std::string_view(), std::string_view()));
+
+    template <typename Handler>
+    using startTagIdEvent = decltype(std::declval<Handler&>().handleStartTag(int(), std::string_view(), std::string_view()));
+
+    template <typename Handler>
+    using endTagIdEvent = decltype(std::declval<Handler&>().handleEndTag(int(), std::string_view(), std::string_view()));
+
+    template <typename Handler>
+    using attributeIdEvent = decltype(std::declval<Handler&>().handleAttribute(int(), std::string_view(), std::string_view()));
+
+    template <typename Handler>
+    using startTagAttributesEvent = decltype(std::declval<Handler&>().handleStartTag(std::string_view(), std::string_view(), std::declval<const XMLAttributes&>()));
+
+    template <typename Handler>
+    using startTagIdAttributesEvent = decltype(std::declval<Handler&>().handleStartTag(int(), std::string_view(), std::string_view(), std::declval<const XMLAttributes&>()));
+
+    template <typename Handler>
+    using startTagNamespaceEvent = decltype(std::declval<Handler&>().handleStartTag(int(), int(), std::string_view(), std::string_view(), std::declval<const XMLAttributes&>()));
+
+    template <typename Handler>
+    using endTagNamespaceEvent = decltype(std::declval<Handler&>().handleEndTag(int(), int(), std::string_view(), std::string_view()));
+
+    template <typename Handler>
+    using namespaceEvent = decltype(std::declval<Handler&>().handleNamespace(std::string_view(), std::string_view()));
+
+    template <typename Handler>
+    using CDATAEvent = decltype(std::declval<Handler&>().handleCDATA(std::string_view()));
+
+    template <typename Handler>
+    using CDATANewlinesEvent = decltype(std::declval<Handler&>().handleCDATA(std::string_view(), long()));
+
+    template <typename Handler>
+    using charactersNewlinesEvent = decltype(std::declval<Handler&>().handleCharacters(std::string_view(), long()));
+
+    template <typename Handler>
+    using entityEvent = decltype(std::declval<Handler&>().handleEntity(std::string_view()));
+
+    template <typename Handler>
+    using charactersEvent = decltype(std::declval<Handler&>().handleCharacters(std::string_view()));
+
+    template <typename Handler>
+    using commentsEvent = decltype(std::declval<Handler&>().handleComments(std::string_view()));
+
+    template <typename Handler>
+    using errorEvent = decltype(std::declval<Handler&>().handleError(std::declval<const XMLError&>()));
+
+    template <typename Handler>
+    using declarationCountEvent = decltype(std::declval<Handler&>().handleDeclaration());
+
+    template <typename Handler>
+    using startTagCountEvent = decltype(std::declval<Handler&>().handleStartTag());
+
+    template <typename Handler>
+    using endTagCountEvent = decltype(std::declval<Handler&>().handleEndTag());
+
+    template <typename Handler>
+    using attributeCountEvent = decltype(std::declval<Handler&>().handleAttribute());
+
+    template <typename Handler>
+    using namespaceCountEvent = decltype(std::declval<Handler&>().handleNamespace());
+
+    template <typename Handler>
+    using CDATACountEvent = decltype(std::declval<Handler&>().handleCDATA());
+
+    template <typename Handler>
+    using entityCountEvent = decltype(std::declval<Handler&>().handleEntity());
+
+    template <typename Handler>
+    using charactersCountEvent = decltype(std::declval<Handler&>().handleCharacters());
+
+    template <typename Handler>
+    using commentsCountEvent = decltype(std::declval<Handler&>().handleComments());
+
+    template <typename Handler> constexpr bool hasDeclaration = detect<Handler, declarationEvent>::value;
+    template <typename Handler> constexpr bool hasStartTag    = detect<Handler, startTagEvent>::value;
+    template <typename Handler> constexpr bool hasEndTag      = detect<Handler, endTagEvent>::value;
+    template <typename Handler> constexpr bool hasAttribute   = detect<Handler, attributeEvent>::value;
+    template <typename Handler> constexpr bool hasStartTagId  = detect<Handler, startTagIdEvent>::value;
+    template <typename Handler> constexpr bool hasEndTagId    = detect<Handler, endTagIdEvent>::value;
+    template <typename Handler> constexpr bool hasAttributeId = detect<Handler, attributeIdEvent>::value;
+    template <typename Handler> constexpr bool hasStartTagAttributes   = detect<Handler, startTagAttributesEvent>::value;
+    template <typename Handler> constexpr bool hasStartTagIdAttributes = detect<Handler, startTagIdAttributesEvent>::value;
+    template <typename Handler> constexpr bool hasStartTagNamespace    = detect<Handler, startTagNamespaceEvent>::value;
+    template <typename Handler> constexpr bool hasEndTagNamespace      = detect<Handler, endTagNamespaceEvent>::value;
+    template <typename Handler> constexpr bool hasNamespace   = detect<Handler, namespaceEvent>::value;
+    template <typename Handler> constexpr bool hasCDATA       = detect<Handler, CDATAEvent>::value;
+    template <typename Handler> constexpr bool hasEntity      = detect<Handler, entityEvent>::value;
+    template <typename Handler> constexpr bool hasCharacters  = detect<Handler, charactersEvent>::value;
+    template <typename Handler> constexpr bool hasComments    = detect<Handler, commentsEvent>::value;
+    template <typename Handler> constexpr bool hasCDATANewlines      = detect<Handler, CDATANewlinesEvent>::value;
+    template <typename Handler> constexpr bool hasCharactersNewlines = detect<Handler, charactersNewlinesEvent>::value;
+    template <typename Handler> constexpr bool hasError       = detect<Handler, errorEvent>::value;
+
+    // events declared with no parameters, only counted
+    template <typename Handler> constexpr bool countsDeclaration = detect<Handler, declarationCountEvent>::value;
+    template <typename Handler> constexpr bool countsStartTag    = detect<Handler, startTagCountEvent>::value;
+    template <typename Handler> constexpr bool countsEndTag      = detect<Handler, endTagCountEvent>::value;
+    template <typename Handler> constexpr bool countsAttribute   = detect<Handler, attributeCountEvent>::value;
+    template <typename Handler> constexpr bool countsNamespace   = detect<Handler, namespaceCountEvent>::value;
+    template <typename Handler> constexpr bool countsCDATA       = detect<Handler, CDATACountEvent>::value;
+    template <typename Handler> constexpr bool countsEntity      = detect<Handler, entityCountEvent>::value;
+    template <typename Handler> constexpr bool countsCharacters  = detect<Handler, charactersCountEvent>::value;
+    template <typename Handler> constexpr bool countsComments    = detect<Handler, commentsCountEvent>::value;
+
+    // are start tags delivered with all of their attributes
+    template <typename Handler> constexpr bool batchesAttributes =
+        hasStartTagAttributes<Handler> || hasStartTagIdAttributes<Handler> || hasStartTagNamespace<Handler>;
+
+    // are namespaces resolved
+    template <typename Handler> constexpr bool resolvesNamespaces = hasStartTagNamespace<Handler> || hasEndTagNamespace<Handler>;
+
+    // are the names of tags used
+    template <typename Handler> constexpr bool usesTagNames =
+        hasStartTag<Handler> || hasStartTagId<Handler> || hasEndTag<Handler> || hasEndTagId<Handler> || batchesAttributes<Handler> ||
+        resolvesNamespaces<Handler>;
+
+    // are attributes or namespaces used, even if only counted
+    template <typename Handler> constexpr bool usesAttributes =
+        hasAttribute<Handler> || hasAttributeId<Handler> || countsAttribute<Handler> || hasNamespace<Handler> || countsNamespace<Handler> ||
+        batchesAttributes<Handler>;
+
+    // does the Op<Handler> event return a control code
+    template <typename Handler, template <typename> class Op, typename = void>
+    struct returnsControl : std::false_type {};
+
+    template <typename Handler, template <typename> class Op>
+    struct returnsControl<Handler, Op, std::void_t<Op<Handler>>> : std::is_same<Op<Handler>, XMLControl> {};
+
+    // does any event return a control code, otherwise control checks compile away
+    template <typename Handler> constexpr bool hasControl =
+        returnsControl<Handler, declarationEvent>::value || returnsControl<Handler, startTagEvent>::value ||
+        returnsControl<Handler, endTagEvent>::value || returnsControl<Handler, attributeEvent>::value ||
+        returnsControl<Handler, startTagIdEvent>::value || returnsControl<Handler, endTagIdEvent>::value ||
+        returnsControl<Handler, attributeIdEvent>::value || returnsControl<Handler, namespaceEvent>::value ||
+        returnsControl<Handler, startTagAttributesEvent>::value || returnsControl<Handler, startTagIdAttributesEvent>::value ||
+        returnsControl<Handler, startTagNamespaceEvent>::value || returnsControl<Handler, endTagNamespaceEvent>::value ||
+        returnsControl<Handler, CDATAEvent>::value || returnsControl<Handler, entityEvent>::value ||
+        returnsControl<Handler, CDATANewlinesEvent>::value || returnsControl<Handler, charactersNewlinesEvent>::value ||
+        returnsControl<Handler, charactersEvent>::value || returnsControl<Handler, commentsEvent>::value ||
+        returnsControl<Handler, declarationCountEvent>::value || returnsControl<Handler, startTagCountEvent>::value ||
+        returnsControl<Handler, endTagCountEvent>::value || returnsControl<Handler, attributeCountEvent>::value ||
+        returnsControl<Handler, namespaceCountEvent>::value || returnsControl<Handler, CDATACountEvent>::value ||
+        returnsControl<Handler, entityCountEvent>::value || returnsControl<Handler, charactersCountEvent>::value ||
+        returnsControl<Handler, commentsCountEvent>::value || returnsControl<Handler, errorEvent>::value;
+}
+
+template <typename Handler>
+class BasicXMLParser {
+public:
+
+    // constructor
+    BasicXMLParser(Handler& handler);
+
+    // constructor, interning names into the caller's table, which must outlive the parser
+    BasicXMLParser(Handler& handler, XMLNameTable& names);
+
+    // handler events may refer to the buffer
+    BasicXMLParser(const BasicXMLParser&) = delete;
+    BasicXMLParser& operator=(const BasicXMLParser&) = delete;
+
+    // parse XML from standard input
+    void parse(long& total);
+
+    // parse XML from a file descriptor, in place when it is a regular file
+    void parse(int fd, long& total);
+
+    // parse XML document in memory, at offset in a larger input in memory, which errors are located in
+    void parse(const char* data, std::size_t len, std::size_t offset = 0);
+
+    // parse XML element content in memory, starting inside depth elements
+    // The content is at offset in a document in memory, and errors are located in the document.
+    void parseFragment(const char* data, std::size_t len, int depth = 1, std::size_t offset = 0);
+
+    // start parsing XML in memory, starting inside depth elements, at offset in a document in memory
+    void beginInput(const char* data, std::size_t len, int depth = 0, std::size_t offset = 0);
+
+    // start parsing XML read ahead from a stream
+    void beginInput(ReadAhead& input);
+
+    // parse the next part of the input, e.g., a tag, an attribute, or characters
+    // @return false when all input is parsed
+    bool parseNext();
+
+    // total bytes read so far
+    long bytesRead() const;
+
+    // interned names, with the IDs given to the handler
+    const XMLNameTable& names() const;
+
+    // parse step counts and timing, only updated when built with XML_PARSER_STATS
+    const XMLParserStats& stats() const;
+
+    // check well-formedness: the nesting of tags, duplicate attributes, and the characters of names
+    void checkWellFormed(bool check = true);
+
+    // number of errors in the current input, only more than one when the handler recovers from them
+    long errors() const;
+
+    // keep totals of the bytes and newlines of text, i.e., characters, CDATA, and entities
+    void countText(bool count = true);
+
+    // bytes of text in the current input, when counted
+    long textBytes() const;
+
+    // newlines in the text of the current input, when counted
+    long textNewlines() const;
+
+    // does buffer need refilled
+    bool needRefill();
+
+    // is done parsing
+    bool isDone();
+
+    // check if declaration
+    bool isXMLDeclaration();
+
+    // check if end tag
+    bool isXMLEndTag();
+
+    // check if start tag
+    bool isXMLStartTag();
+
+    // check if namespace
+    bool isXMLNamespace();
+
+    // check if attribute
+    bool isXMLAttribute();
+
+    // check if CDATA
+    bool isXMLCData();
+
+    // check if comment
+    bool isXMLComment();
+
+    // check if characters before XML
+    bool isBeforeXML();
+
+    // check if entity
+    bool isXMLEntity();
+
+    // check if characters
+    bool isXMLCharacters();
+
+    // refill buffer
+    void refill(long& total);
+
+    // parse xml declaration
+    void parseXMLDeclaration(long& total);
+
+    // parse xml end tag
+    void parseXMLEndTag(long& total);
+
+    // parse xml start tag
+    void parseXMLStartTag(long& total);
+
+    // parse xml namespace
+    void parseXMLNamespace();
+
+    // parse xml attribute
+    void parseXMLAttribute();
+
+    // parse xml CDATA
+    void parseXMLCDATA(long& total);
+
+    // parse xml comment
+    void parseXMLComment(long& total);
+
+    // parse characters before xml
+    void parseBeforeXML();
+
+    // parse xml entity reference
+    void parseXMLEntity(long& total);
+
+    // parse xml characters
+    void parseXMLCharacters();
+
+private:
+
+    // view of the buffer characters [first, last)
+    std::string_view bufferView(const char* first, const char* last) const;
+
+    // start tag handler, with the name ID if the handler takes it
+    void startTagEvent(std::string_view qname, std::string_view local_name, std::string_view prefix);
+
+    // end tag handler, with the name ID if the handler takes it
+    void endTagEvent(std::string_view qname, std::string_view local_name, std::string_view prefix);
+
+    // end tag handler for the start tag whose attributes were parsed
+    void emptyEndTagEvent();
+
+    // parse the attributes and namespace declarations of the start tag, up to its '>' at endpc
+    // @return is the element empty
+    bool parseAttributes(const char* endpc);
+
+    // call the handler, and keep any control code it returns
+    template <typename Call>
+    void dispatch(Call call);
+
+    // report the error at the byte to the handler, then recover, or without an error handler, exit
+    void error(XMLErrorKind kind, const char* at, std::string message);
+
+    // report the error to the handler, then recover, or without an error handler, exit
+    void error(const XMLError& failure);
+
+    // report the failure of the compressed input that ended the stream, and skip what is left
+    void inputError();
+
+    // did an error in this parse step end it, with the input already moved to where parsing resumes
+    bool hasFailed() const;
+
+    // resume parsing at the next top-level unit, or skip the rest of the input if there is none
+    void recover();
+
+    // end the elements left open by an error, down to the depth
+    void endOpenElements(int enddepth);
+
+    // byte offset in the input of the buffer character
+    long offsetOf(const char* at) const;
+
+    // check the characters of the name the first time its ID is seen
+    // Names checked are views of the buffer, and errors are at the start of the name, wherever the parse is.
+    void checkName(int id, std::string_view qname, const char* kind);
+
+    // are the open elements kept, to check end tags, or to end them after an error
+    bool tracksElements() const;
+
+    // check the start tag, before its element is opened
+    // @return ID of the name
+    int checkStartTag(std::string_view qname);
+
+    // check the end tag is of the open element, and close it
+    void checkEndTag(std::string_view qname);
+
+    // close the empty element
+    void checkEmptyEnd();
+
+    // check the attribute with the name ID is not already in its start tag
+    void checkAttribute(int id, std::string_view qname);
+
+    // check the document has a root element, and all elements are closed
+    void checkEnd();
+
+    // skip the rest of the element at skipdepth, up to its end tag
+    void skipElement(long& total);
+
+    static constexpr int XMLNS_SIZE = std::char_traits<char>::length("xmlns");
+
+    // zeroed bytes after the buffer characters, so lookahead never leaves the buffer
+    static constexpr int BUFFER_PADDING = 16;
+
+    Handler& handler;
+
+    bool intag = false;
+    std::string buffer;
+    const char* pc = nullptr;
+    const char* bufferend = nullptr;
+    const char* pnameend = nullptr;
+    const char* pvalueend = nullptr;
+
+    // attributes of the start tag, for handlers that take them in one event
+    XMLAttributes attributes;
+
+    // UTF-8 characters of the last reference
+    char entitycharacters[XML_MAX_UTF8];
+
+    // name of the start tag whose attributes are being parsed
+    std::string_view taglocalname;
+    std::string_view tagprefix;
+    int tagid = -1;
+
+    // qualified names of elements and attributes, in the parser's own table or the caller's
+    XMLNameTable ownnames;
+    XMLNameTable& nametable;
+
+    // namespace bindings of the open elements, for handlers that take namespace IDs
+    XMLNamespaceResolver resolver{nametable};
+
+    // well-formedness checks, with the name IDs of the open elements and of the attributes of the start tag
+    bool checking = false;
+    int startdepth = 0;
+    bool rootseen = false;
+    std::vector<int> openelements;
+    std::vector<int> tagattributes;
+    std::vector<char> validnames;
+
+    // totals of the text in the current input, when counted
+    bool countingtext = false;
+    long textbytes = 0;
+    long textnewlines = 0;
+
+    // errors in the current input, and the name of the last top-level unit, to recover at the next
+    long errorcount = 0;
+    bool failed = false;
+    std::string unitname;
+
+    // the stream ended early on a failure of the compressed input, not yet reported
+    bool inputfailed = false;
+
+    // control code from a handler, and the depth of the element to skip
+    XMLControl control = XMLControl::Continue;
+    int skipdepth = 0;
+
+    // in-memory input after the buffer characters, and the start of its document, or nullptr when reading
+    const char* memoryend = nullptr;
+    const char* memorystart = nullptr;
+
+    // read-ahead input, or nullptr when in memory
+    ReadAhead* stream = nullptr;
+    bool eof = false;
+    int depth = 0;
+    long totalBytes = 0;
+
+    // bytes of input parsed so far
+    long bytesParsed() const;
+
+    // record the kind of the current parse step
+    void statsStep(XMLParserStats::Kind kind);
+
+    // parse the next part of the input, with the kind of step recorded
+    bool parseStep();
+
+    XMLParserStats parserStats;
+    XMLParserStats::Kind stepKind = XMLParserStats::None;
+};
+
+// constructor
+template <typename Handler>
+BasicXMLParser<Handler>::BasicXMLParser(Handler& handler)
+    : BasicXMLParser(handler, ownnames)
+{}
+
+// constructor, interning names into the caller's table, which must outlive the parser
+template <typename Handler>
+BasicXMLParser<Handler>::BasicXMLParser(Handler& handler, XMLNameTable& names)
+    : handler(handler), nametable(names)
+{
+
+    pc = bufferend = buffer.data();
+}
+
+// parse XML from standard input
+template <typename Handler>
+void BasicXMLParser<Handler>::parse(long& total) {
+
+    parse(0, total);
+}
+
+// parse XML from a file descriptor, in place when it is a regular file
+template <typename Handler>
+void BasicXMLParser<Handler>::parse(int fd, long& total) {
+
+    MappedFile file(fd);
+    if (file.isMapped()) {
+        parse(file.data(), file.size());
+        total += totalBytes;
+        return;
+    }
+
+    // read ahead in chunks starting from empty
+    ReadAhead input(fd);
+    beginInput(input);
+    while (parseNext())
+        ;
+    stream = nullptr;
+    if (checking && control != XMLControl::Stop)
+        checkEnd();
+    total += totalBytes;
+}
+
+// parse XML document in memory, at offset in a larger input in memory, which errors are located in
+template <typename Handler>
+void BasicXMLParser<Handler>::parse(const char* data, std::size_t len, std::size_t offset) {
+
+    parseFragment(data, len, 0, offset);
+    if (checking && control != XMLControl::Stop)
+        checkEnd();
+}
+
+// parse XML element content in memory, starting inside depth elements
+// The content is at offset in a document in memory, and errors are located in the document.
+template <typename Handler>
+void BasicXMLParser<Handler>::parseFragment(const char* data, std::size_t len, int depth, std::size_t offset) {
+
+    beginInput(data, len, depth, offset);
+    while (parseNext())
+        ;
+}
+
+// start parsing XML in memory, starting inside depth elements, at offset in a document in memory
+template <typename Handler>
+void BasicXMLParser<Handler>::beginInput(const char* data, std::size_t len, int depth, std::size_t offset) {
+
+    // parse in place, except for the end which goes into the padded buffer
+    const std::size_t inplace = len > (std::size_t) BUFFER_PADDING ? len - BUFFER_PADDING : 0;
+    pc = data;
+    bufferend = data + inplace;
+    memoryend = data + len;
+    memorystart = data - offset;
+    stream = nullptr;
+    eof = false;
+    totalBytes = (long) (offset + len);
+    intag = false;
+    this->depth = depth;
+    control = XMLControl::Continue;
+    startdepth = depth;
+    rootseen = false;
+    openelements.clear();
+    errorcount = 0;
+    unitname.clear();
+    inputfailed = false;
+    textbytes = 0;
+    textnewlines = 0;
+    if constexpr (xml_detail::resolvesNamespaces<Handler>)
+        resolver.reset();
+}
+
+// start parsing XML read ahead from a stream
+template <typename Handler>
+void BasicXMLParser<Handler>::beginInput(ReadAhead& input) {
+
+    // read ahead in chunks starting from empty
+    stream = &input;
+    pc = bufferend = nullptr;
+    memoryend = nullptr;
+    memorystart = nullptr;
+    eof = false;
+    totalBytes = 0;
+    intag = false;
+    depth = 0;
+    control = XMLControl::Continue;
+    startdepth = 0;
+    rootseen = false;
+    openelements.clear();
+    errorcount = 0;
+    unitname.clear();
+    inputfailed = false;
+    textbytes = 0;
+    textnewlines = 0;
+    if constexpr (xml_detail::resolvesNamespaces<Handler>)
+        resolver.reset();
+}
+
+// parse the next part of the input, e.g., a tag, an attribute, or characters
+template <typename Handler>
+XML_PARSER_INLINE bool BasicXMLParser<Handler>::parseNext() {
+
+#if defined(XML_PARSER_STATS)
+    // time and bytes of the step, by the kind of step
+    const std::uint64_t start = XMLParserStats::now();
+    const long startBytes = bytesParsed();
+    stepKind = XMLParserStats::None;
+    const bool more = parseStep();
+    if (stepKind != XMLParserStats::None)
+        parserStats.add(stepKind, XMLParserStats::now() - start, bytesParsed() - startBytes);
+
+    return more;
+#else
+    return parseStep();
+#endif
+}
+
+// bytes of input parsed so far
+template <typename Handler>
+long BasicXMLParser<Handler>::bytesParsed() const {
+
+    return offsetOf(pc);
+}
+
+// byte offset in the input of the buffer character
+template <typename Handler>
+long BasicXMLParser<Handler>::offsetOf(const char* at) const {
+
+    // in memory, the input not yet in the buffer is still to parse
+    const char* end = memoryend != nullptr && !eof ? memoryend : bufferend;
+    return totalBytes - (long) std::distance(at, end);
+}
+
+// record the kind of the current parse step
+template <typename Handler>
+XML_PARSER_INLINE void BasicXMLParser<Handler>::statsStep([[maybe_unused]] XMLParserStats::Kind kind) {
+
+#if defined(XML_PARSER_STATS)
+    stepKind = kind;
+#endif
+}
+
+// parse the next part of the input, with the kind of step recorded
+template <typename Handler>
+XML_PARSER_INLINE bool BasicXMLParser<Handler>::parseStep() {
+
+    if constexpr (xml_detail::hasError<Handler>)
+        failed = false;
+
+    // handler stopped parsing, or skips an element
+    if constexpr (xml_detail::hasControl<Handler>) {
+        if (control == XMLControl::Stop)
+            return false;
+        if (control == XMLControl::SkipSubtree) {
+            statsStep(XMLParserStats::Skip);
+            skipElement(totalBytes);
+            return true;
+        }
+    }
+
+    if (needRefill()) {
+
+        // refill buffer
+        statsStep(XMLParserStats::Refill);
+        refill(totalBytes);
+
+    } else if (isDone()) {
+
+        // all input parsed, unless the compressed input failed
+        if (inputfailed)
+            inputError();
+        return false;
+
+    } else if (isXMLDeclaration()) {
+
+        // parse XML declaration
+        statsStep(XMLParserStats::Declaration);
+        parseXMLDeclaration(totalBytes);
+
+    } else if (isXMLEndTag()) {
+        // parse end tag
+        statsStep(XMLParserStats::EndTag);
+        parseXMLEndTag(totalBytes);
+
+    } else if (isXMLStartTag()) {
+        // parse start tag
+        statsStep(XMLParserStats::StartTag);
+        parseXMLStartTag(totalBytes);
+
+    } else if (isXMLNamespace()) {
+
+        // parse namespace
+        statsStep(XMLParserStats::Namespace);
+        parseXMLNamespace();
+
+    } else if (isXMLAttribute()) {
+
+        // parse attribute
+        statsStep(XMLParserStats::Attribute);
+        parseXMLAttribute();
+
+    } else if (isXMLCData()) {
+
+        // parse CDATA
+        statsStep(XMLParserStats::CDATA);
+        parseXMLCDATA(totalBytes);
+
+    } else if (isXMLComment()) {
+
+        // parse XML comment
+        statsStep(XMLParserStats::Comment);
+        parseXMLComment(totalBytes);
+
+    } else if (isBeforeXML()) {
+
+        // parse characters before or after XML
+        statsStep(XMLParserStats::BeforeXML);
+        parseBeforeXML();
+
+    } else if (isXMLEntity()) {
+
+        // parse entity references
+        statsStep(XMLParserStats::Entity);
+        parseXMLEntity(totalBytes);
+
+    } else if (isXMLCharacters()) {
+
+        // parse characters
+        statsStep(XMLParserStats::Characters);
+        parseXMLCharacters();
+    }
+
+    return true;
+}
+
+// total bytes read so far
+template <typename Handler>
+long BasicXMLParser<Handler>::bytesRead() const {
+
+    return totalBytes;
+}
+
+// interned names, with the IDs given to the handler
+template <typename Handler>
+const XMLNameTable& BasicXMLParser<Handler>::names() const {
+
+    return nametable;
+}
+
+// parse step counts and timing, only updated when built with XML_PARSER_STATS
+template <typename Handler>
+const XMLParserStats& BasicXMLParser<Handler>::stats() const {
+
+    return parserStats;
+}
+
+// check well-formedness: the nesting of tags, duplicate attributes, and the characters of names
+template <typename Handler>
+void BasicXMLParser<Handler>::checkWellFormed(bool check) {
+
+    checking = check;
+}
+
+// number of errors in the current input, only more than one when the handler recovers from them
+template <typename Handler>
+long BasicXMLParser<Handler>::errors() const {
+
+    return errorcount;
+}
+
+// keep totals of the bytes and newlines of text, i.e., characters, CDATA, and entities
+template <typename Handler>
+void BasicXMLParser<Handler>::countText(bool count) {
+
+    countingtext = count;
+}
+
+// bytes of text in the current input, when counted
+template <typename Handler>
+long BasicXMLParser<Handler>::textBytes() const {
+
+    return textbytes;
+}
+
+// newlines in the text of the current input, when counted
+template <typename Handler>
+long BasicXMLParser<Handler>::textNewlines() const {
+
+    return textnewlines;
+}
+
+// does buffer need refilled
+template <typename Handler>
+XML_PARSER_INLINE bool BasicXMLParser<Handler>::needRefill() {
+
+    // a start tag is complete in the buffer, so do not refill until its end
+    return !eof && !intag && (std::distance(pc, bufferend) < 5);
+}
+
+// is done parsing
+template <typename Handler>
+XML_PARSER_INLINE bool BasicXMLParser<Handler>::isDone() {
+
+    return pc == bufferend;
+}
+
+// check if declaration
+template <typename Handler>
+XML_PARSER_INLINE bool BasicXMLParser<Handler>::isXMLDeclaration() {
+
+    return (*pc == '<' && *std::next(pc) == '?');
+}
+
+// check if end tag
+template <typename Handler>
+XML_PARSER_INLINE bool BasicXMLParser<Handler>::isXMLEndTag() {
+
+    return (*pc == '<' && *std::next(pc) == '/');
+}
+
+// check if start tag
+template <typename Handler>
+XML_PARSER_INLINE bool BasicXMLParser<Handler>::isXMLStartTag() {
+
+    return (*pc == '<' && *std::next(pc) != '/' && *std::next(pc) != '?' && *std::next(pc) != '!');
+}
+
+// check if namespace
+template <typename Handler>
+XML_PARSER_INLINE bool BasicXMLParser<Handler>::isXMLNamespace() {
+
+    return (intag && *pc != '>' && *pc != '/' && std::distance(pc, bufferend) > (int) XMLNS_SIZE && std::string_view(pc, XMLNS_SIZE) == "xmlns"
+    && (*std::next(pc, XMLNS_SIZE) == ':' || *std::next(pc, XMLNS_SIZE) == '='));
+}
+
+// check if attribute
+template <typename Handler>
+XML_PARSER_INLINE bool BasicXMLParser<Handler>::isXMLAttribute() {
+
+    return (intag && *pc != '>' && *pc != '/');
+}
+
+// check if CDATA
+template <typename Handler>
+XML_PARSER_INLINE bool BasicXMLParser<Handler>::isXMLCData() {
+
+    return (*pc == '<' && *std::next(pc) == '!' && *std::next(pc, 2) == '[');
+}
+
+// check if comment
+template <typename Handler>
+XML_PARSER_INLINE bool BasicXMLParser<Handler>::isXMLComment() {
+
+    return (*pc == '<' && *std::next(pc) == '!' && *std::next(pc, 2) == '-' && *std::next(pc, 3) == '-');
+}
+
+// check if characters before XML
+template <typename Handler>
+XML_PARSER_INLINE bool BasicXMLParser<Handler>::isBeforeXML() {
+
+    return (*pc != '<' && depth == 0);
+}
+
+// check if entity
+template <typename Handler>
+XML_PARSER_INLINE bool BasicXMLParser<Handler>::isXMLEntity() {
+
+    return (*pc == '&');
+}
+
+// check if characters
+template <typename Handler>
+XML_PARSER_INLINE bool BasicXMLParser<Handler>::isXMLCharacters() {
+
+    return (*pc != '<');
+}
+
+// refill buffer
+template <typename Handler>
+void BasicXMLParser<Handler>::refill(long& total) {
+
+    if (eof)
+        return;
+
+#if defined(XML_PARSER_STATS)
+    // refills not at a token boundary complete a partial token
+    ++parserStats.refills;
+    parserStats.tailBytes += (long) std::distance(pc, memoryend != nullptr ? memoryend : bufferend);
+    if (stepKind != XMLParserStats::Refill)
+        ++parserStats.partialTokens;
+#endif
+
+    if (memoryend != nullptr) {
+
+        // move the rest of the in-memory input into the padded buffer
+        buffer.assign(pc, memoryend);
+        const auto size = buffer.size();
+        buffer.append(BUFFER_PADDING, '\0');
+        pc = buffer.data();
+        bufferend = pc + size;
+        eof = true;
+        return;
+    }
+
+    // unparsed characters are stitched in front of the next chunk
+    const long before = stream->bytesRead();
+    if (!stream->next(pc, bufferend)) {
+        eof = true;
+        inputfailed = stream->failed();
+    }
+    total += stream->bytesRead() - before;
+}
+
+// parse xml declaration
+template <typename Handler>
+void BasicXMLParser<Handler>::parseXMLDeclaration(long& total) {
+
+    auto endpc = scanChar(pc, bufferend, '>');
+    while (endpc == bufferend && !eof) {
+        refill(total);
+        endpc = scanChar(pc, bufferend, '>');
+    }
+    if (endpc == bufferend) {
+        error(XMLErrorKind::Declaration, pc, "Incomplete XML declaration");
+        return;
+    }
+    std::advance(pc, strlen("<?xml"));
+    pc = skipSpace(pc, endpc);
+
+    endpc = scanChar(pc, bufferend, '>');
+    if (pc == endpc) {
+        error(XMLErrorKind::Declaration, pc, "Missing space after before version in XML declaration");
+        return;
+    }
+    pnameend = scanChar(pc, endpc, '=');
+    const std::string_view attr = bufferView(pc, pnameend);
+    pc = pnameend;
+    std::advance(pc, 1);
+    char delim = *pc;
+    if (delim != '"' && delim != '\'') {
+        error(XMLErrorKind::Declaration, pc, "Invalid start delimiter for version in XML declaration");
+        return;
+    }
+    std::advance(pc, 1);
+    pvalueend = scanChar(pc, endpc, delim);
+    if (pvalueend == endpc) {
+        error(XMLErrorKind::Declaration, pc, "Invalid end delimiter for version in XML declaration");
+        return;
+    }
+    if (attr != "version") {
+        error(XMLErrorKind::Declaration, pc, "Missing required first attribute version in XML declaration");
+        return;
+    }
+    const std::string_view version = bufferView(pc, pvalueend);
+    pc = std::next(pvalueend);
+    pc = skipSpace(pc, endpc);
+
+    endpc = scanChar(pc, bufferend, '>');
+    if (pc == endpc) {
+        error(XMLErrorKind::Declaration, pc, "Missing required encoding in XML declaration");
+        return;
+    }
+    pnameend = scanChar(pc, endpc, '=');
+    if (pnameend == endpc) {
+        error(XMLErrorKind::Declaration, pc, "Incomple encoding in XML declaration");
+        return;
+    }
+    const std::string_view attr2 = bufferView(pc, pnameend);
+    pc = pnameend;
+    std::advance(pc, 1);
+    char delim2 = *pc;
+    if (delim2 != '"' && delim2 != '\'') {
+        error(XMLErrorKind::Declaration, pc, "Invalid end delimiter for encoding in XML declaration");
+        return;
+    }
+    std::advance(pc, 1);
+    pvalueend = scanChar(pc, endpc, delim2);
+    if (pvalueend == endpc) {
+        error(XMLErrorKind::Declaration, pc, "Incomple encoding in XML declaration");
+        return;
+    }
+    if (attr2 != "encoding") {
+         error(XMLErrorKind::Declaration, pc, "Missing required encoding in XML declaration");
+         return;
+    }
+    const std::string_view encoding = bufferView(pc, pvalueend);
+    pc = std::next(pvalueend);
+    pc = skipSpace(pc, endpc);
+
+    endpc = scanChar(pc, bufferend, '>');
+    if (pc == endpc) {
+        error(XMLErrorKind::Declaration, pc, "Missing required third attribute standalone in XML declaration");
+        return;
+    }
+    pnameend = scanChar(pc, endpc, '=');
+    const std::string_view attr3 = bufferView(pc, pnameend);
+    pc = pnameend;
+    std::advance(pc, 1);
+    char delim3 = *pc;
+    if (delim3 != '"' && delim3 != '\'') {
+        error(XMLErrorKind::Declaration, pc, "Missing attribute standalone delimiter in XML declaration");
+        return;
+    }
+    std::advance(pc, 1);
+    pvalueend = scanChar(pc, endpc, delim3);
+    if (pvalueend == endpc) {
+        error(XMLErrorKind::Declaration, pc, "Missing attribute standalone in XML declaration");
+        return;
+    }
+    if (attr3 != "standalone") {
+        error(XMLErrorKind::Declaration, pc, "Missing attribute standalone in XML declaration");
+        return;
+    }
+    const std::string_view standalone = bufferView(pc, pvalueend);
+    pc = std::next(pvalueend);
+    pc = skipSpace(pc, endpc);
+    std::advance(pc, strlen("?>"));
+    pc = skipSpace(pc, bufferend);
+
+    if constexpr (xml_detail::hasDeclaration<Handler>)
+        dispatch([&] { return handler.handleDeclaration(version, encoding, standalone); });
+    else if constexpr (xml_detail::countsDeclaration<Handler>)
+        dispatch([&] { return handler.handleDeclaration(); });
+}
+
+// parse xml end tag
+template <typename Handler>
+void BasicXMLParser<Handler>::parseXMLEndTag(long& total) {
+
+    --depth;
+    auto endpc = scanChar(pc, bufferend, '>');
+    while (endpc == bufferend && !eof) {
+        refill(total);
+        endpc = scanChar(pc, bufferend, '>');
+    }
+    if (endpc == bufferend) {
+        error(XMLErrorKind::EndTag, pc, "Incomplete element end tag");
+        return;
+    }
+
+    // name is not used, except to check it is of the open element
+    if constexpr (!xml_detail::usesTagNames<Handler>) {
+        if (checking) {
+            const char* pname = std::next(pc, 2);
+            checkEndTag(bufferView(pname, std::find_if(pname, endpc, isXMLNameEnd)));
+            if (hasFailed())
+                return;
+        }
+        pc = std::next(endpc);
+        endTagEvent(std::string_view(), std::string_view(), std::string_view());
+        return;
+    }
+
+    std::advance(pc, 2);
+    auto pnameend = std::find_if(pc, std::next(endpc), isXMLNameEnd);
+    if (pnameend == std::next(endpc)) {
+          error(XMLErrorKind::EndTag, pc, "Incomplete element end tag name");
+          return;
+    }
+    const std::string_view qname = bufferView(pc, pnameend);
+    const auto colonpos = qname.find(':');
+    const std::string_view prefix = colonpos != std::string_view::npos ? qname.substr(0, colonpos) : std::string_view();
+    const std::string_view local_name = colonpos != std::string_view::npos ? qname.substr(colonpos + 1) : qname;
+    if (tracksElements()) {
+        checkEndTag(qname);
+        if (hasFailed())
+            return;
+    }
+    pc = std::next(endpc);
+
+    endTagEvent(qname, local_name, prefix);
+}
+
+// parse xml start tag
+template <typename Handler>
+void BasicXMLParser<Handler>::parseXMLStartTag(long& total) {
+
+    auto endpc = scanChar(pc, bufferend, '>');
+    while (endpc == bufferend && !eof) {
+        refill(total);
+        endpc = scanChar(pc, bufferend, '>');
+    }
+    if (endpc == bufferend) {
+        error(XMLErrorKind::StartTag, pc, "Incomplete element start tag");
+        return;
+    }
+
+    // name of a top-level unit, where parsing resumes after an error
+    if constexpr (xml_detail::hasError<Handler>) {
+        if (depth == 1)
+            unitname.assign(std::next(pc), std::find_if(std::next(pc), endpc, isXMLNameEnd));
+    }
+
+    // neither the name nor the attributes are used, so skip the whole tag, unless checking
+    if constexpr (!xml_detail::usesTagNames<Handler> && !xml_detail::usesAttributes<Handler>) {
+        if (!checking) {
+            const bool empty = *std::prev(endpc) == '/';
+            pc = std::next(endpc);
+            ++depth;
+            startTagEvent(std::string_view(), std::string_view(), std::string_view());
+            if (empty) {
+                --depth;
+                endTagEvent(std::string_view(), std::string_view(), std::string_view());
+            }
+            return;
+        }
+    }
+
+    std::advance(pc, 1);
+    auto pnameend = std::find_if(pc, std::next(endpc), isXMLNameEnd);
+    if (pnameend == std::next(endpc)) {
+        error(XMLErrorKind::StartTag, pc, "Unterminated start tag '" + std::string(pc, pnameend) + "'");
+        return;
+    }
+    const std::string_view qname = bufferView(pc, pnameend);
+    const auto colonpos = qname.find(':');
+    const std::string_view prefix = colonpos != std::string_view::npos ? qname.substr(0, colonpos) : std::string_view();
+    const std::string_view local_name = colonpos != std::string_view::npos ? qname.substr(colonpos + 1) : qname;
+    const int checkedid = tracksElements() ? checkStartTag(qname) : -1;
+    if (hasFailed())
+        return;
+    pc = pnameend;
+
+    // the start tag with all of its attributes in one event
+    if constexpr (xml_detail::batchesAttributes<Handler>) {
+
+        // the element is only open once its start tag is delivered, so an error in the attributes leaves nothing to end
+        const bool empty = parseAttributes(endpc);
+        if (hasFailed())
+            return;
+        ++depth;
+        if (tracksElements())
+            openelements.push_back(checkedid);
+        if constexpr (xml_detail::hasStartTagNamespace<Handler>) {
+
+            // declarations of the tag apply to the element and all of its attributes
+            for (const XMLAttribute& attribute : attributes)
+                if (attribute.isNamespace)
+                    resolver.bind(attribute.prefix, attribute.value, depth);
+            for (std::size_t i = 0; i < attributes.size(); ++i)
+                if (!attributes[i].isNamespace)
+                    attributes[i].namespaceId = resolver.attribute(attributes[i].id);
+            const int id = checkedid != -1 ? checkedid : nametable.intern(qname);
+            dispatch([&] { return handler.handleStartTag(id, resolver.element(id), local_name, prefix, std::as_const(attributes)); });
+        } else if constexpr (xml_detail::hasStartTagIdAttributes<Handler>)
+            dispatch([&] { return handler.handleStartTag(checkedid != -1 ? checkedid : nametable.intern(qname), local_name, prefix, std::as_const(attributes)); });
+        else
+            dispatch([&] { return handler.handleStartTag(local_name, prefix, std::as_const(attributes)); });
+        if (empty) {
+            --depth;
+            if (tracksElements())
+                checkEmptyEnd();
+            endTagEvent(qname, local_name, prefix);
+        }
+        return;
+    }
+
+    pc = skipSpace(pc, std::next(endpc));
+    ++depth;
+    if (tracksElements())
+        openelements.push_back(checkedid);
+    intag = true;
+    if (intag && *pc == '>') {
+        std::advance(pc, 1);
+        intag = false;
+    }
+
+    bool empty = false;
+    if (intag && *pc == '/' && *std::next(pc) == '>') {
+        std::advance(pc, 2);
+        intag = false;
+        empty = true;
+    }
+
+    startTagEvent(qname, local_name, prefix);
+
+    // the end of an element with attributes is found by the last attribute
+    if (intag) {
+        taglocalname = local_name;
+        tagprefix = prefix;
+        if constexpr (xml_detail::hasEndTagId<Handler> || xml_detail::hasEndTagNamespace<Handler>)
+            tagid = checkedid != -1 ? checkedid : nametable.intern(qname);
+    }
+
+    // empty element
+    if (empty) {
+        --depth;
+        if (tracksElements())
+            checkEmptyEnd();
+        endTagEvent(qname, local_name, prefix);
+    }
+}
+
+// parse xml namespace
+template <typename Handler>
+void BasicXMLParser<Handler>::parseXMLNamespace(){
+
+    const char* pqname = pc;
+    std::advance(pc, XMLNS_SIZE);
+    auto endpc = scanChar(pc, bufferend, '>');
+    auto pnameend = scanChar(pc, std::next(endpc), '=');
+
+    if (pnameend == std::next(endpc)) {
+        error(XMLErrorKind::Namespace, pc, "incomplete namespace");
+        return;
+    }
+    if (checking) {
+        checkAttribute(nametable.intern(bufferView(pqname, pnameend)), bufferView(pqname, pnameend));
+        if (hasFailed())
+            return;
+    }
+//    pc = pnameend;
+    std::string_view prefix;
+    if (*pc == ':') {
+        std::advance(pc, 1);
+        prefix = bufferView(pc, pnameend);
+    }
+    pc = std::next(pnameend);
+    pc = skipSpace(pc, std::next(endpc));
+    if (pc == std::next(endpc)) {
+        error(XMLErrorKind::Namespace, pc, "incomplete namespace");
+        return;
+    }
+    const char delim = *pc;
+    if (delim != '"' && delim != '\'') {
+        error(XMLErrorKind::Namespace, pc, "incomplete namespace");
+        return;
+    }
+    std::advance(pc, 1);
+    auto pvalueend = scanChar(pc, std::next(endpc), delim);
+    if (pvalueend == std::next(endpc)) {
+        error(XMLErrorKind::Namespace, pc, "incomplete namespace");
+        return;
+    }
+    const std::string_view uri = bufferView(pc, pvalueend);
+    pc = std::next(pvalueend);
+    pc = skipSpace(pc, std::next(endpc));
+    if (intag && *pc == '>') {
+        std::advance(pc, 1);
+        intag = false;
+    }
+    bool empty = false;
+    if (intag && *pc == '/' && *std::next(pc) == '>') {
+        std::advance(pc, 2);
+        intag = false;
+        empty = true;
+    }
+
+    // without the batched start tag, declarations are bound as they are parsed
+    if constexpr (xml_detail::resolvesNamespaces<Handler>)
+        resolver.bind(prefix, uri, depth);
+
+    if constexpr (xml_detail::hasNamespace<Handler>)
+        dispatch([&] { return handler.handleNamespace(uri, prefix); });
+    else if constexpr (xml_detail::countsNamespace<Handler>)
+        dispatch([&] { return handler.handleNamespace(); });
+
+    // empty element
+    if (empty) {
+        --depth;
+        if (tracksElements())
+            checkEmptyEnd();
+        emptyEndTagEvent();
+    }
+}
+
+// parse xml attribute
+template <typename Handler>
+void BasicXMLParser<Handler>::parseXMLAttribute() {
+
+    auto endpc = scanChar(pc, bufferend, '>');
+    auto pnameend = scanChar(pc, std::next(endpc), '=');
+    if (pnameend == std::next(endpc)) {
+        error(XMLErrorKind::Attribute, pc, "Incomplete attribute in start tag");
+        return;
+    }
+    const std::string_view qname = bufferView(pc, pnameend);
+    if (checking) {
+        checkAttribute(nametable.intern(qname), qname);
+        if (hasFailed())
+            return;
+    }
+    const auto colonpos = qname.find(':');
+    const std::string_view local_name = colonpos != std::string_view::npos ? qname.substr(colonpos + 1) : qname;
+    pc = std::next(pnameend);
+    pc = skipSpace(pc, std::next(endpc));
+    if (pc == bufferend) {
+        error(XMLErrorKind::Attribute, pc, "attribute " + std::string(qname) + " incomplete attribute");
+        return;
+    }
+    char delim = *pc;
+    if (delim != '"' && delim != '\'') {
+        error(XMLErrorKind::Attribute, pc, "attribute " + std::string(qname) + " missing delimiter");
+        return;
+    }
+    std::advance(pc, 1);
+    auto pvalueend = scanChar(pc, std::next(endpc), delim);
+    if (pvalueend == std::next(endpc)) {
+        error(XMLErrorKind::Attribute, pc, "attribute " + std::string(qname) + " missing delimiter");
+        return;
+    }
+
+    const std::string_view value = bufferView(pc, pvalueend);
+
+    pc = std::next(pvalueend);
+    pc = skipSpace(pc, std::next(endpc));
+    if (intag && *pc == '>') {
+        std::advance(pc, 1);
+        intag = false;
+    }
+    bool empty = false;
+    if (intag && *pc == '/' && *std::next(pc) == '>') {
+        std::advance(pc, 2);
+        intag = false;
+        empty = true;
+    }
+
+    if constexpr (xml_detail::hasAttributeId<Handler>)
+        dispatch([&] { return handler.handleAttribute(nametable.intern(qname), local_name, value); });
+    else if constexpr (xml_detail::hasAttribute<Handler>)
+        dispatch([&] { return handler.handleAttribute(local_name, value); });
+    else if constexpr (xml_detail::countsAttribute<Handler>)
+        dispatch([&] { return handler.handleAttribute(); });
+
+    // empty element
+    if (empty) {
+        --depth;
+        if (tracksElements())
+            checkEmptyEnd();
+        emptyEndTagEvent();
+    }
+}
+
+// parse xml CDATA
+template <typename Handler>
+void BasicXMLParser<Handler>::parseXMLCDATA(long& total) {
+
+    std::advance(pc, strlen("<![CDATA["));
+    auto endpc = scanSequence(pc, bufferend, "]]>");
+    while (endpc == bufferend && !eof) {
+        refill(total);
+        endpc = scanSequence(pc, bufferend, "]]>");
+    }
+    if (endpc == bufferend) {
+        error(XMLErrorKind::CDATA, pc, "Unterminated CDATA section");
+        return;
+    }
+    const std::string_view characters = bufferView(pc, endpc);
+    pc = std::next(endpc, strlen("]]>"));
+
+    // newlines are counted in a separate scan, since the end is found by a sequence
+    long newlines = 0;
+    if (xml_detail::hasCDATANewlines<Handler> || countingtext)
+        newlines = countChar(characters.data(), characters.data() + characters.size(), '\n');
+    if (countingtext) {
+        textbytes += (long) characters.size();
+        textnewlines += newlines;
+    }
+
+    if constexpr (xml_detail::hasCDATANewlines<Handler>)
+        dispatch([&] { return handler.handleCDATA(characters, newlines); });
+    else if constexpr (xml_detail::hasCDATA<Handler>)
+        dispatch([&] { return handler.handleCDATA(characters); });
+    else if constexpr (xml_detail::countsCDATA<Handler>)
+        dispatch([&] { return handler.handleCDATA(); });
+}
+
+// parse xml comment
+template <typename Handler>
+void BasicXMLParser<Handler>::parseXMLComment(long& total) {
+
+    auto endpc = scanSequence(pc, bufferend, "-->");
+    while (endpc == bufferend && !eof) {
+        refill(total);
+        endpc = scanSequence(pc, bufferend, "-->");
+    }
+    if (endpc == bufferend) {
+        error(XMLErrorKind::Comment, pc, "Unterminated XML comment");
+        return;
+    }
+    const std::string_view comment = bufferView(std::next(pc, strlen("<!--")), endpc);
+    pc = std::next(endpc, strlen("-->"));
+    pc = skipSpace(pc, bufferend);
+
+    if constexpr (xml_detail::hasComments<Handler>)
+        dispatch([&] { return handler.handleComments(comment); });
+    else if constexpr (xml_detail::countsComments<Handler>)
+        dispatch([&] { return handler.handleComments(); });
+}
+
+// parse characters before xml
+template <typename Handler>
+void BasicXMLParser<Handler>::parseBeforeXML(){
+
+    pc = skipSpace(pc, bufferend);
+    if (pc != bufferend && *pc != '<') {
+        error(XMLErrorKind::Content, pc, "Start tag expected, '<' not found");
+        return;
+    }
+}
+
+// parse xml entity reference
+template <typename Handler>
+void BasicXMLParser<Handler>::parseXMLEntity(long& total) {
+
+    // a reference may continue in the next chunk
+    if (std::distance(pc, bufferend) < XML_MAX_REFERENCE && !eof)
+        refill(total);
+
+    // a '&' that is not a complete reference is itself the characters
+    std::string_view characters;
+    int size = 0;
+    const char* end = decodeXMLReference(pc, bufferend, entitycharacters, size);
+    if (end != pc) {
+        characters = std::string_view(entitycharacters, size);
+        pc = end;
+    } else {
+        characters = "&";
+        std::advance(pc, 1);
+    }
+    if (countingtext) {
+        textbytes += (long) characters.size();
+        textnewlines += (long) std::count(characters.begin(), characters.end(), '\n');
+    }
+
+    if constexpr (xml_detail::hasEntity<Handler>)
+        dispatch([&] { return handler.handleEntity(characters); });
+    else if constexpr (xml_detail::countsEntity<Handler>)
+        dispatch([&] { return handler.handleEntity(); });
+}
+
+// parse xml characters
+template <typename Handler>
+void BasicXMLParser<Handler>::parseXMLCharacters() {
+
+    // newlines are counted in the same scan
+    long newlines = 0;
+    const bool counting = xml_detail::hasCharactersNewlines<Handler> || countingtext;
+    const char* endpc = counting ? scanEitherCount(pc, bufferend, '<', '&', '\n', newlines)
+                                 : scanEither(pc, bufferend, '<', '&');
+
+    // characters that reach the end of the buffer continue in the next, so they are one event however the input is read
+    while (endpc == bufferend && !eof) {
+        const auto scanned = std::distance(pc, endpc);
+        refill(totalBytes);
+        endpc = counting ? scanEitherCount(std::next(pc, scanned), bufferend, '<', '&', '\n', newlines)
+                         : scanEither(std::next(pc, scanned), bufferend, '<', '&');
+    }
+    const std::string_view characters = bufferView(pc, endpc);
+    pc = endpc;
+    if (countingtext) {
+        textbytes += (long) characters.size();
+        textnewlines += newlines;
+    }
+
+    if constexpr (xml_detail::hasCharactersNewlines<Handler>)
+        dispatch([&] { return handler.handleCharacters(characters, newlines); });
+    else if constexpr (xml_detail::hasCharacters<Handler>)
+        dispatch([&] { return handler.handleCharacters(characters); });
+    else if constexpr (xml_detail::countsCharacters<Handler>)
+        dispatch([&] { return handler.handleCharacters(); });
+}
+
+// view of the buffer characters [first, last)
+template <typename Handler>
+std::string_view BasicXMLParser<Handler>::bufferView(const char* first, const char* last) const {
+
+    return std::string_view(first, std::distance(first, last));
+}
+
+// start tag handler, with the name ID if the handler takes it
+template <typename Handler>
+void BasicXMLParser<Handler>::startTagEvent(std::string_view qname, std::string_view local_name, std::string_view prefix) {
+
+    if constexpr (xml_detail::hasStartTagId<Handler>)
+        dispatch([&] { return handler.handleStartTag(nametable.intern(qname), local_name, prefix); });
+    else if constexpr (xml_detail::hasStartTag<Handler>)
+        dispatch([&] { return handler.handleStartTag(local_name, prefix); });
+    else if constexpr (xml_detail::countsStartTag<Handler>)
+        dispatch([&] { return handler.handleStartTag(); });
+}
+
+// end tag handler, with the name ID if the handler takes it
+template <typename Handler>
+void BasicXMLParser<Handler>::endTagEvent(std::string_view qname, std::string_view local_name, std::string_view prefix) {
+
+    if constexpr (xml_detail::hasEndTagNamespace<Handler>) {
+        const int id = nametable.intern(qname);
+        dispatch([&] { return handler.handleEndTag(id, resolver.element(id), local_name, prefix); });
+    } else if constexpr (xml_detail::hasEndTagId<Handler>)
+        dispatch([&] { return handler.handleEndTag(nametable.intern(qname), local_name, prefix); });
+    else if constexpr (xml_detail::hasEndTag<Handler>)
+        dispatch([&] { return handler.handleEndTag(local_name, prefix); });
+    else if constexpr (xml_detail::countsEndTag<Handler>)
+        dispatch([&] { return handler.handleEndTag(); });
+
+    // declarations of the element end with it
+    if constexpr (xml_detail::resolvesNamespaces<Handler>)
+        resolver.endElement(depth + 1);
+}
+
+// end tag handler for the start tag whose attributes were parsed
+template <typename Handler>
+void BasicXMLParser<Handler>::emptyEndTagEvent() {
+
+    if constexpr (xml_detail::hasEndTagNamespace<Handler>)
+        dispatch([&] { return handler.handleEndTag(tagid, resolver.element(tagid), taglocalname, tagprefix); });
+    else if constexpr (xml_detail::hasEndTagId<Handler>)
+        dispatch([&] { return handler.handleEndTag(tagid, taglocalname, tagprefix); });
+    else if constexpr (xml_detail::hasEndTag<Handler>)
+        dispatch([&] { return handler.handleEndTag(taglocalname, tagprefix); });
+    else if constexpr (xml_detail::countsEndTag<Handler>)
+        dispatch([&] { return handler.handleEndTag(); });
+
+    // declarations of the element end with it
+    if constexpr (xml_detail::resolvesNamespaces<Handler>)
+        resolver.endElement(depth + 1);
+}
+
+// parse the attributes and namespace declarations of the start tag, up to its '>' at endpc
+template <typename Handler>
+bool BasicXMLParser<Handler>::parseAttributes(const char* endpc) {
+
+    attributes.clear();
+    pc = skipSpace(pc, endpc);
+    while (pc != endpc && *pc != '/') {
+        const char* pnameend = scanChar(pc, endpc, '=');
+        if (pnameend == endpc) {
+            error(XMLErrorKind::Attribute, pc, "Incomplete attribute in start tag");
+            return false;
+        }
+        const std::string_view qname = bufferView(pc, std::find_if(pc, pnameend, isXMLSpace));
+        pc = skipSpace(std::next(pnameend), endpc);
+        if (pc == endpc || (*pc != '"' && *pc != '\'')) {
+            error(XMLErrorKind::Attribute, pc, "attribute " + std::string(qname) + " missing delimiter");
+            return false;
+        }
+        const char delim = *pc;
+        std::advance(pc, 1);
+        const char* pvalueend = scanChar(pc, endpc, delim);
+        if (pvalueend == endpc) {
+            error(XMLErrorKind::Attribute, pc, "attribute " + std::string(qname) + " missing delimiter");
+            return false;
+        }
+
+        XMLAttribute attribute;
+        attribute.value = bufferView(pc, pvalueend);
+        if (qname.substr(0, XMLNS_SIZE) == "xmlns" && (qname.size() == XMLNS_SIZE || qname[XMLNS_SIZE] == ':')) {
+            attribute.isNamespace = true;
+            if (qname.size() > XMLNS_SIZE)
+                attribute.prefix = qname.substr(XMLNS_SIZE + 1);
+        } else {
+            const auto colonpos = qname.find(':');
+            attribute.prefix = colonpos != std::string_view::npos ? qname.substr(0, colonpos) : std::string_view();
+            attribute.local_name = colonpos != std::string_view::npos ? qname.substr(colonpos + 1) : qname;
+            if constexpr (xml_detail::hasStartTagIdAttributes<Handler> || xml_detail::hasStartTagNamespace<Handler>)
+                attribute.id = nametable.intern(qname);
+        }
+        if (checking) {
+            checkAttribute(attribute.id != -1 ? attribute.id : nametable.intern(qname), qname);
+            if (hasFailed())
+                return false;
+        }
+        attributes.push_back(attribute);
+        pc = skipSpace(std::next(pvalueend), endpc);
+    }
+
+    // only "/>" ends the tag before its '>'
+    const bool empty = pc != endpc;
+    pc = std::next(endpc);
+
+    return empty;
+}
+
+// check the characters of the name the first time its ID is seen
+template <typename Handler>
+void BasicXMLParser<Handler>::checkName(int id, std::string_view qname, const char* kind) {
+
+    if ((std::size_t) id >= validnames.size())
+        validnames.resize(nametable.size(), false);
+    if (validnames[id])
+        return;
+
+    if (qname.empty() || !isXMLNameStart(qname.front()) || !std::all_of(qname.begin(), qname.end(), isXMLNameChar)) {
+        error(XMLErrorKind::Name, qname.data(), "Invalid " + std::string(kind) + " name '" + std::string(qname) + "'");
+        return;
+    }
+    validnames[id] = true;
+}
+
+// are the open elements kept, to check end tags, or to end them after an error
+template <typename Handler>
+XML_PARSER_INLINE bool BasicXMLParser<Handler>::tracksElements() const {
+
+    if constexpr (xml_detail::hasError<Handler> && xml_detail::usesTagNames<Handler>)
+        return true;
+    else
+        return checking;
+}
+
+// check the start tag, before its element is opened
+// @return ID of the name
+template <typename Handler>
+int BasicXMLParser<Handler>::checkStartTag(std::string_view qname) {
+
+    // without checking, the ID is only needed to keep the open element
+    if (!checking)
+        return nametable.intern(qname);
+
+    // a document has one root element
+    if (startdepth == 0 && openelements.empty()) {
+        if (rootseen) {
+            error(XMLErrorKind::Root, pc, "Extra content at the end of the document, element <" + std::string(qname) + ">");
+            return -1;
+        }
+        rootseen = true;
+    }
+    const int id = nametable.intern(qname);
+    checkName(id, qname, "element");
+    if (hasFailed())
+        return -1;
+    tagattributes.clear();
+
+    return id;
+}
+
+// check the end tag is of the open element, and close it
+template <typename Handler>
+void BasicXMLParser<Handler>::checkEndTag(std::string_view qname) {
+
+    if (!checking) {
+        if (!openelements.empty())
+            openelements.pop_back();
+        return;
+    }
+
+    // a fragment may end elements it did not start
+    if (openelements.empty()) {
+        if (startdepth == 0)
+            error(XMLErrorKind::MismatchedEndTag, qname.data(), "End tag </" + std::string(qname) + "> with no open element");
+        return;
+    }
+
+    // compared by name, since the ID of the open element is known
+    if (nametable.qname(openelements.back()) != qname) {
+        error(XMLErrorKind::MismatchedEndTag, qname.data(), "Mismatched end tag </" + std::string(qname) + ">, expected </" + std::string(nametable.qname(openelements.back())) + ">");
+        return;
+    }
+    openelements.pop_back();
+}
+
+// close the empty element
+template <typename Handler>
+void BasicXMLParser<Handler>::checkEmptyEnd() {
+
+    openelements.pop_back();
+}
+
+// check the attribute with the name ID is not already in its start tag
+template <typename Handler>
+void BasicXMLParser<Handler>::checkAttribute(int id, std::string_view qname) {
+
+    checkName(id, qname, "attribute");
+    if (hasFailed())
+        return;
+    if (std::find(tagattributes.begin(), tagattributes.end(), id) != tagattributes.end()) {
+        error(XMLErrorKind::DuplicateAttribute, qname.data(), "Duplicate attribute '" + std::string(qname) + "'");
+        return;
+    }
+    tagattributes.push_back(id);
+}
+
+// check the document has a root element, and all elements are closed
+template <typename Handler>
+void BasicXMLParser<Handler>::checkEnd() {
+
+    if (!openelements.empty())
+        error(XMLErrorKind::UnclosedElement, pc, "Premature end of data, unclosed element <" + std::string(nametable.qname(openelements.back())) + ">");
+    else if (startdepth == 0 && !rootseen)
+        error(XMLErrorKind::Root, pc, "Document has no root element");
+}
+
+// report the error at the byte to the handler, then recover, or without an error handler, exit
+template <typename Handler>
+void BasicXMLParser<Handler>::error(XMLErrorKind kind, const char* at, std::string message) {
+
+    // what is left after a failure of the compressed input is incomplete, so report the failure instead
+    if (inputfailed) {
+        inputError();
+        return;
+    }
+
+    XMLError failure;
+    failure.kind = kind;
+    failure.offset = offsetOf(at);
+    failure.message = std::move(message);
+
+    // line and column are only counted now, and only the input in memory is still there
+    if (memorystart != nullptr) {
+        const char* const location = memorystart + failure.offset;
+        const char* linestart = location;
+        while (linestart != memorystart && *std::prev(linestart) != '\n')
+            --linestart;
+        failure.line = countChar(memorystart, linestart, '\n') + 1;
+        failure.column = (long) std::distance(linestart, location) + 1;
+    }
+
+    error(failure);
+}
+
+// report the error to the handler, then recover, or without an error handler, exit
+template <typename Handler>
+void BasicXMLParser<Handler>::error(const XMLError& failure) {
+
+    ++errorcount;
+    if constexpr (xml_detail::hasError<Handler>) {
+
+        failed = true;
+        bool stop = false;
+        if constexpr (xml_detail::returnsControl<Handler, xml_detail::errorEvent>::value)
+            stop = handler.handleError(std::as_const(failure)) == XMLControl::Stop;
+        else
+            handler.handleError(std::as_const(failure));
+        if (stop)
+            control = XMLControl::Stop;
+        else
+            recover();
+
+    } else {
+
+        std::cerr << "parser error : " << failure << '\n';
+        exit(1);
+    }
+}
+
+// report the failure of the compressed input that ended the stream, and skip what is left
+template <typename Handler>
+void BasicXMLParser<Handler>::inputError() {
+
+    inputfailed = false;
+    pc = bufferend;
+    error(stream->failure());
+}
+
+// did an error in this parse step end it, with the input already moved to where parsing resumes
+template <typename Handler>
+XML_PARSER_INLINE bool BasicXMLParser<Handler>::hasFailed() const {
+
+    if constexpr (xml_detail::hasError<Handler>)
+        return failed;
+    else
+        return false;
+}
+
+// resume parsing at the next top-level unit, or skip the rest of the input if there is none
+template <typename Handler>
+void BasicXMLParser<Handler>::recover() {
+
+    control = XMLControl::Continue;
+    intag = false;
+
+    // next start tag with the name of the unit, after the start of the failed markup
+    // Each refill keeps a possible partial tag at the end of the buffer.
+    const long size = (long) unitname.size() + 2;
+    const char* from = pc != bufferend ? std::next(pc) : pc;
+    while (!unitname.empty()) {
+        const char* found = scanChar(from, bufferend, '<');
+        if (std::distance(found, bufferend) < size) {
+            if (eof)
+                break;
+            pc = found;
+            refill(totalBytes);
+            from = pc;
+            continue;
+        }
+        if (std::memcmp(std::next(found), unitname.data(), unitname.size()) == 0 && isXMLNameEnd(found[size - 1])) {
+
+            // the unit is in the root element, or at the depth of the fragment
+            endOpenElements(1);
+            pc = found;
+            depth = 1;
+            if constexpr (xml_detail::resolvesNamespaces<Handler>)
+                resolver.endElement(2);
+            return;
+        }
+        from = std::next(found);
+    }
+
+    // no unit follows, so the rest of the input is not parsed
+    endOpenElements(0);
+    pc = bufferend;
+    while (!eof) {
+        refill(totalBytes);
+        pc = bufferend;
+    }
+    depth = 0;
+    if constexpr (xml_detail::resolvesNamespaces<Handler>)
+        resolver.endElement(1);
+}
+
+// end the elements left open by an error, down to the depth
+// Elements a fragment did not start are not ended.
+template <typename Handler>
+void BasicXMLParser<Handler>::endOpenElements(int enddepth) {
+
+    // by name, when the open elements are kept
+    if (tracksElements()) {
+        const std::size_t keep = (std::size_t) std::max(0, enddepth - startdepth);
+        while (openelements.size() > keep) {
+            const std::string_view qname = nametable.qname(openelements.back());
+            openelements.pop_back();
+            depth = startdepth + (int) openelements.size();
+            const auto colonpos = qname.find(':');
+            const std::string_view prefix = colonpos != std::string_view::npos ? qname.substr(0, colonpos) : std::string_view();
+            const std::string_view local_name = colonpos != std::string_view::npos ? qname.substr(colonpos + 1) : qname;
+            endTagEvent(qname, local_name, prefix);
+        }
+        return;
+    }
+
+    // otherwise by depth, since the names are not used
+    while (depth > std::max(enddepth, startdepth)) {
+        --depth;
+        endTagEvent(std::string_view(), std::string_view(), std::string_view());
+    }
+}
+
+// call the handler, and keep any control code it returns
+template <typename Handler>
+template <typename Call>
+void BasicXMLParser<Handler>::dispatch(Call call) {
+
+    if constexpr (std::is_same_v<decltype(call()), XMLControl>) {
+        const XMLControl result = call();
+        if (result != XMLControl::Continue && control != XMLControl::Stop) {
+            control = result;
+            skipdepth = depth;
+        }
+    } else {
+        call();
+    }
+}
+
+// skip the rest of the element at skipdepth, up to its end tag
+template <typename Handler>
+void BasicXMLParser<Handler>::skipElement(long& total) {
+
+    control = XMLControl::Continue;
+
+    // element already ended, e.g., an empty element
+    if (depth < skipdepth)
+        return;
+
+    // rest of the start tag, which is complete in the buffer
+    if (intag) {
+        const char* endpc = scanChar(pc, bufferend, '>');
+        if (endpc == bufferend) {
+            error(XMLErrorKind::StartTag, pc, "Unterminated start tag");
+            return;
+        }
+        pc = std::next(endpc);
+        intag = false;
+        if (*std::prev(endpc) == '/') {
+            --depth;
+            if (tracksElements())
+                checkEmptyEnd();
+            emptyEndTagEvent();
+            return;
+        }
+    }
+
+    // depth-counting scan over the content, stopping at the end tag with no nesting
+    int nesting = 0;
+    while (true) {
+        pc = scanChar(pc, bufferend, '<');
+
+        // refill until markup is complete, or to the end of input at depth 0
+        // Lookahead for the kind of markup may be into the zeroed padding.
+        const char* endpc = bufferend;
+        if (pc != bufferend && (eof || std::distance(pc, bufferend) >= (long) strlen("<![CDATA["))) {
+            if (std::memcmp(pc, "<!--", strlen("<!--")) == 0) {
+                endpc = scanSequence(std::next(pc, strlen("<!--")), bufferend, "-->");
+                if (endpc != bufferend)
+                    std::advance(endpc, strlen("--"));
+            } else if (std::memcmp(pc, "<![CDATA[", strlen("<![CDATA[")) == 0) {
+                endpc = scanSequence(std::next(pc, strlen("<![CDATA[")), bufferend, "]]>");
+                if (endpc != bufferend)
+                    std::advance(endpc, strlen("]]"));
+            } else {
+                endpc = scanChar(pc, bufferend, '>');
+            }
+        }
+        if (endpc == bufferend) {
+            if (eof) {
+                if (pc == bufferend)
+                    return;
+                error(XMLErrorKind::Markup, pc, "Incomplete markup in skipped element");
+                return;
+            }
+            refill(total);
+            continue;
+        }
+
+        if (pc[1] == '/') {
+
+            // end tag of the skipped element is parsed as usual
+            if (nesting == 0)
+                return;
+            --nesting;
+
+        } else if (pc[1] != '!' && pc[1] != '?' && *std::prev(endpc) != '/') {
+
+            // start tag of a non-empty element
+            ++nesting;
+        }
+        pc = std::next(endpc);
+    }
+}
+
+#endif
@@ -0,0 +1,253 @@
+/*
+    InputDecoder.cpp
+
+    Implementation file for reading compressed input
+*/
+
+#include "InputDecoder.hpp"
+
+#include <algorithm>
+#include <string>
+#include <cstring>
+#include <errno.h>
+
+#if defined(XML_HAVE_ZLIB)
+#include <zlib.h>
+#endif
+
+#if !defined(_MSC_VER)
+#include <unistd.h>
+#define READ read
+#else
+#include <BaseTsd.h>
+#include <io.h>
+typedef SSIZE_T ssize_t;
+#define READ _read
+#endif
+
+// zlib stream
+struct InputDecoder::Stream {
+#if defined(XML_HAVE_ZLIB)
+    z_stream z{};
+#endif
+};
+
+namespace {
+
+    // size of a zip local file header before the name and extra field
+    const std::size_t ZIP_HEADER_SIZE = 30;
+
+    // little-endian 16-bit field
+    unsigned int field16(const char* p) {
+
+        return (unsigned char) p[0] | ((unsigned char) p[1] << 8);
+    }
+}
+
+// compression of the input from its first bytes
+Compression detectCompression(const char* data, std::size_t len) {
+
+    if (len >= 2 && (unsigned char) data[0] == 0x1f && (unsigned char) data[1] == 0x8b)
+        return Compression::Gzip;
+    if (len >= 4 && std::memcmp(data, "PK\x03\x04", 4) == 0)
+        return Compression::Zip;
+
+    return Compression::None;
+}
+
+// read from the file descriptor
+InputDecoder::InputDecoder(int fd)
+    : fd(fd)
+{}
+
+// end decompression
+InputDecoder::~InputDecoder() {
+
+#if defined(XML_HAVE_ZLIB)
+    if (stream)
+        inflateEnd(&stream->z);
+#endif
+}
+
+// compression of the input, after the first read
+Compression InputDecoder::compression() const {
+
+    return kind;
+}
+
+// read more compressed input after any unused input
+bool InputDecoder::fill() {
+
+    if (inputDone)
+        return false;
+
+    // move unused input to the front
+    std::copy(input.data() + first, input.data() + last, input.data());
+    last -= first;
+    first = 0;
+
+    while (last < input.size()) {
+        const ssize_t numbytes = ::READ(fd, (void*)(input.data() + last), input.size() - last);
+        if (numbytes == (ssize_t) -1 && errno == EINTR)
+            continue;
+        if (numbytes <= 0) {
+            inputDone = true;
+            break;
+        }
+        last += (std::size_t) numbytes;
+
+        // compressed input is consumed in blocks, so do not wait to fill
+        if (started)
+            break;
+    }
+
+    return last != first;
+}
+
+// failure of the compressed input, after read() returns -1
+const XMLError& InputDecoder::failure() const {
+
+    return error;
+}
+
+// end the input with the failure at the current decoded offset
+long InputDecoder::fail(std::string message) {
+
+    failed = true;
+    error.kind = XMLErrorKind::Compression;
+    error.offset = decoded;
+    error.message = std::move(message);
+
+    return -1;
+}
+
+// skip the local file header of the first zip entry
+bool InputDecoder::skipZipHeader() {
+
+    while (last - first < ZIP_HEADER_SIZE && fill())
+        ;
+    if (last - first < ZIP_HEADER_SIZE) {
+        fail("Incomplete zip header");
+        return false;
+    }
+
+    const char* header = input.data() + first;
+    const unsigned int method = field16(header + 8);
+    const std::size_t size = ZIP_HEADER_SIZE + field16(header + 26) + field16(header + 28);
+    if (method != 8) {
+        fail("Unsupported zip compression method " + std::to_string(method));
+        return false;
+    }
+    while (last - first < size && fill())
+        ;
+    if (last - first < size) {
+        fail("Incomplete zip header");
+        return false;
+    }
+    first += size;
+
+    return true;
+}
+
+// read the first bytes, and start decompression if needed
+bool InputDecoder::start() {
+
+    input.resize(INPUT_SIZE);
+    fill();
+    started = true;
+    kind = detectCompression(input.data() + first, last - first);
+    if (kind == Compression::None)
+        return true;
+
+#if defined(XML_HAVE_ZLIB)
+    stream.reset(new Stream);
+    int status = Z_OK;
+    if (kind == Compression::Gzip) {
+
+        // gzip header, detected by zlib
+        status = inflateInit2(&stream->z, 15 + 16);
+    } else {
+
+        // raw deflate after the local file header
+        if (!skipZipHeader())
+            return false;
+        status = inflateInit2(&stream->z, -15);
+    }
+    if (status != Z_OK) {
+        fail("Unable to start decompression");
+        return false;
+    }
+
+    return true;
+#else
+    fail("Compressed input requires zlib");
+    return false;
+#endif
+}
+
+// read up to size decoded bytes into the buffer
+long InputDecoder::read(char* buffer, long size) {
+
+    if (failed || (!started && !start()))
+        return -1;
+
+    if (kind == Compression::None) {
+
+        // the first bytes, then directly from the file descriptor
+        if (first != last) {
+            const long count = std::min(size, (long) (last - first));
+            std::memcpy(buffer, input.data() + first, (std::size_t) count);
+            first += (std::size_t) count;
+            decoded += count;
+            return count;
+        }
+        while (true) {
+            const ssize_t numbytes = ::READ(fd, (void*) buffer, (std::size_t) size);
+            if (numbytes == (ssize_t) -1 && errno == EINTR)
+                continue;
+            const long count = numbytes > 0 ? (long) numbytes : 0;
+            decoded += count;
+            return count;
+        }
+    }
+
+#if defined(XML_HAVE_ZLIB)
+    z_stream& z = stream->z;
+    z.next_out = (Bytef*) buffer;
+    z.avail_out = (uInt) size;
+    while (z.avail_out > 0 && !streamDone) {
+
+        if (first == last && !fill())
+            break;
+
+        z.next_in = (Bytef*) (input.data() + first);
+        z.avail_in = (uInt) (last - first);
+        const int status = inflate(&z, Z_NO_FLUSH);
+        first = last - z.avail_in;
+        if (status == Z_STREAM_END) {
+
+            // a gzip file can have more members, but zip is only the first entry
+            if (kind == Compression::Gzip && (first != last || fill()))
+                inflateReset(&z);
+            else
+                streamDone = true;
+
+        } else if (status != Z_OK && status != Z_BUF_ERROR) {
+
+            // bytes decoded before the corruption are still returned, and the next read fails
+            const long count = size - (long) z.avail_out;
+            decoded += count;
+            fail("Corrupt compressed input");
+            return count != 0 ? count : -1;
+        }
+    }
+    const long count = size - (long) z.avail_out;
+    decoded += count;
+    if (count == 0 && !streamDone && size != 0)
+        return fail("Truncated compressed input");
+
+    return count;
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,99 @@
+/*
+    InputDecoder.hpp
+
+    Reads a file descriptor, decompressing gzip and zip input. The
+    compression is detected from the first bytes, so compressed and
+    plain XML are read the same way. Plain input is read directly
+    into the caller's buffer.
+
+    For zip, the first entry of the archive is read. Decompression
+    requires zlib, i.e., XML_HAVE_ZLIB.
+
+    Corrupt, truncated, or unsupported compressed input ends the input
+    with a failure, at the byte offset of the decoded input where it
+    happened, and the caller decides what to do with it.
+*/
+
+#ifndef INCLUDED_INPUTDECODER_HPP
+#define INCLUDED_INPUTDECODER_HPP
+
+#include "XMLError.hpp"
+
+#include <cstddef>
+#include <vector>
+#include <memory>
+
+// compression of input
+enum class Compression {
+    None,
+    Gzip,
+    Zip
+};
+
+// compression of the input from its first bytes
+Compression detectCompression(const char* data, std::size_t len);
+
+class InputDecoder {
+public:
+
+    // read from the file descriptor
+    InputDecoder(int fd);
+
+    // end decompression
+    ~InputDecoder();
+
+    InputDecoder(const InputDecoder&) = delete;
+    InputDecoder& operator=(const InputDecoder&) = delete;
+
+    // read up to size decoded bytes into the buffer
+    // @return number of bytes read, 0 at the end of input, or -1 on failure
+    long read(char* buffer, long size);
+
+    // compression of the input, after the first read
+    Compression compression() const;
+
+    // failure of the compressed input, after read() returns -1
+    const XMLError& failure() const;
+
+private:
+
+    // read the first bytes, and start decompression if needed
+    // @return false on failure
+    bool start();
+
+    // read more compressed input after any unused input
+    // @return false at the end of input
+    bool fill();
+
+    // skip the local file header of the first zip entry
+    // @return false on failure
+    bool skipZipHeader();
+
+    // end the input with the failure at the current decoded offset
+    // @return -1
+    long fail(std::string message);
+
+    static constexpr std::size_t INPUT_SIZE = 256 * 1024;
+
+    int fd;
+    bool started = false;
+    bool inputDone = false;
+    bool streamDone = false;
+    Compression kind = Compression::None;
+
+    // decoded bytes read so far, and the failure that ended them
+    long decoded = 0;
+    bool failed = false;
+    XMLError error;
+
+    // compressed input, or the first plain bytes, in [first, last)
+    std::vector<char> input;
+    std::size_t first = 0;
+    std::size_t last = 0;
+
+    // zlib stream
+    struct Stream;
+    std::unique_ptr<Stream> stream;
+};
+
+#endif
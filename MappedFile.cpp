@@ -0,0 +1,105 @@
+/*
+    MappedFile.cpp
+
+    Implementation file for read-only memory map of a regular file.
+    Anything that cannot be mapped, e.g., pipes and terminals, is left
+    unmapped, and the caller falls back to reading. So is compressed
+    input, since it cannot be parsed in place.
+*/
+
+#include "MappedFile.hpp"
+#include "InputDecoder.hpp"
+
+#include <iostream>
+#include <cstdlib>
+
+#if !defined(_MSC_VER)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// map the file open on the file descriptor, if it is a regular file
+MappedFile::MappedFile(int fd) {
+
+#if !defined(_MSC_VER)
+    struct stat info;
+    if (fstat(fd, &info) == -1 || !S_ISREG(info.st_mode))
+        return;
+
+    // only map input that has not been partially consumed
+    if (lseek(fd, 0, SEEK_CUR) != 0)
+        return;
+
+    // an empty file has nothing to map, but is still a regular file
+    if (info.st_size == 0) {
+        contents = "";
+        mapped = true;
+        return;
+    }
+
+    void* address = mmap(nullptr, (std::size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED)
+        return;
+
+    // compressed input is read through the decoder instead
+    if (detectCompression(static_cast<const char*>(address), (std::size_t) info.st_size) != Compression::None) {
+        munmap(address, (std::size_t) info.st_size);
+        return;
+    }
+    madvise(address, (std::size_t) info.st_size, MADV_SEQUENTIAL);
+
+    contents = static_cast<const char*>(address);
+    length = (std::size_t) info.st_size;
+    mapped = true;
+#endif
+}
+
+// unmap
+MappedFile::~MappedFile() {
+
+#if !defined(_MSC_VER)
+    if (mapped && length != 0)
+        munmap(const_cast<char*>(contents), length);
+#endif
+}
+
+// is the file mapped
+bool MappedFile::isMapped() const {
+
+    return mapped;
+}
+
+// start of the file contents
+const char* MappedFile::data() const {
+
+    return contents;
+}
+
+// size of the file contents
+std::size_t MappedFile::size() const {
+
+    return length;
+}
+
+// read all of the rest of the input, decompressed, e.g., when it cannot be mapped
+std::string readAll(int fd) {
+
+    InputDecoder decoder(fd);
+    std::string contents;
+    const std::size_t BLOCK_SIZE = 16 * 16 * 4096;
+    while (true) {
+        const std::size_t size = contents.size();
+        contents.resize(size + BLOCK_SIZE);
+        const long numbytes = decoder.read(contents.data() + size, (long) BLOCK_SIZE);
+        contents.resize(size + (numbytes > 0 ? (std::size_t) numbytes : 0));
+        if (numbytes == -1) {
+            std::cerr << "parser error : " << decoder.failure() << '\n';
+            exit(1);
+        }
+        if (numbytes == 0)
+            break;
+    }
+
+    return contents;
+}
@@ -0,0 +1,44 @@
+/*
+    MappedFile.hpp
+
+    Read-only memory map of a regular file, unless it is compressed
+*/
+
+#ifndef INCLUDED_MAPPEDFILE_HPP
+#define INCLUDED_MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <string>
+
+class MappedFile {
+public:
+
+    // map the file open on the file descriptor, if it is a regular file
+    MappedFile(int fd);
+
+    // unmap
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // is the file mapped
+    bool isMapped() const;
+
+    // start of the file contents
+    const char* data() const;
+
+    // size of the file contents
+    std::size_t size() const;
+
+private:
+    const char* contents = nullptr;
+    std::size_t length = 0;
+    bool mapped = false;
+};
+
+// read all of the rest of the input, decompressed, e.g., when it cannot be mapped
+// Exits on corrupt compressed input, since the whole input is needed.
+std::string readAll(int fd);
+
+#endif
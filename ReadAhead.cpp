@@ -0,0 +1,152 @@
+/*
+    ReadAhead.cpp
+
+    Implementation file for the read-ahead input stage
+*/
+
+#include "ReadAhead.hpp"
+
+#include <algorithm>
+
+// start reading from the file descriptor
+ReadAhead::ReadAhead(int fd)
+    : decoder(fd)
+{
+
+    for (auto& chunk : chunks)
+        chunk.data.resize(STITCH_SIZE + CHUNK_SIZE + PADDING);
+
+    reader = std::thread(&ReadAhead::readChunks, this);
+}
+
+// stop reading
+ReadAhead::~ReadAhead() {
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    reader.join();
+}
+
+// read chunks until EOF or stopped
+void ReadAhead::readChunks() {
+
+    for (long n = 0; ; ++n) {
+
+        // wait for the parser to release the chunk
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this, n]() { return stopping || n - released < NUM_CHUNKS; });
+            if (stopping)
+                return;
+        }
+
+        // fill the whole chunk, pipes and decompression return less than asked for
+        Chunk& chunk = chunks[n % NUM_CHUNKS];
+        char* start = chunk.data.data() + STITCH_SIZE;
+        long length = 0;
+        bool eof = false;
+        bool failure = false;
+        while (length < CHUNK_SIZE) {
+            const long numbytes = decoder.read(start + length, CHUNK_SIZE - length);
+
+            // error in read or EOF, or failure of compressed input
+            if (numbytes <= 0) {
+                eof = true;
+                failure = numbytes == -1;
+                break;
+            }
+
+            length += numbytes;
+        }
+        std::fill_n(start + length, PADDING, '\0');
+        chunk.length = length;
+
+        // publish the chunk
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++filled;
+            done = eof;
+            readfailed = failure;
+        }
+        changed.notify_all();
+
+        if (eof)
+            return;
+    }
+}
+
+// replace the window [pc, bufferend) with the unparsed tail followed by the next chunk
+bool ReadAhead::next(const char*& pc, const char*& bufferend) {
+
+    // wait for the reader
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this]() { return filled > nextchunk || done; });
+        if (filled == nextchunk)
+            return false;
+    }
+
+    Chunk& chunk = chunks[nextchunk % NUM_CHUNKS];
+    char* start = chunk.data.data() + STITCH_SIZE;
+    const long tailsize = (long) std::distance(pc, bufferend);
+    if (tailsize <= STITCH_SIZE) {
+
+        // stitch the tail in front of the chunk data
+        std::copy(pc, bufferend, start - tailsize);
+        pc = start - tailsize;
+        bufferend = start + chunk.length;
+        current = nextchunk;
+
+    } else {
+
+        // tail is too large for the stitch area, so combine in the overflow
+        std::string combined;
+        combined.reserve(tailsize + chunk.length + PADDING);
+        combined.append(pc, tailsize);
+        combined.append(start, chunk.length);
+        combined.append(PADDING, '\0');
+        overflow.swap(combined);
+        pc = overflow.data();
+        bufferend = pc + tailsize + chunk.length;
+        current = -1;
+    }
+    stitched += tailsize;
+    total += chunk.length;
+    ++nextchunk;
+
+    // release all chunks before the current one
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        released = current >= 0 ? current : nextchunk;
+    }
+    changed.notify_all();
+
+    return true;
+}
+
+// total bytes read by the parser
+long ReadAhead::bytesRead() const {
+
+    return total;
+}
+
+// bytes copied to stitch tokens across chunks
+long ReadAhead::bytesStitched() const {
+
+    return stitched;
+}
+
+// did a failure of the compressed input end the input, once next() returns false
+bool ReadAhead::failed() const {
+
+    return readfailed;
+}
+
+// failure of the compressed input, when failed()
+const XMLError& ReadAhead::failure() const {
+
+    return decoder.failure();
+}
@@ -0,0 +1,101 @@
+/*
+    ReadAhead.hpp
+
+    Read-ahead input stage. A background thread reads the file
+    descriptor into a ring of chunk buffers while the parser works
+    on the current chunk.
+
+    Each chunk has a stitch area in front of its data. A token that
+    crosses a chunk boundary is completed by copying the unparsed tail
+    of the previous chunk into the stitch area, so only the partial
+    token is copied, never the whole buffer.
+
+    Compressed input is decompressed by the background thread, so
+    decompression and parsing overlap, with the ring of chunks as the
+    bounded queue between them. A failure of the compressed input ends
+    the input early, and is kept for the parser to report at EOF.
+*/
+
+#ifndef INCLUDED_READAHEAD_HPP
+#define INCLUDED_READAHEAD_HPP
+
+#include "InputDecoder.hpp"
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class ReadAhead {
+public:
+
+    // start reading from the file descriptor
+    ReadAhead(int fd);
+
+    // stop reading
+    ~ReadAhead();
+
+    ReadAhead(const ReadAhead&) = delete;
+    ReadAhead& operator=(const ReadAhead&) = delete;
+
+    // replace the window [pc, bufferend) with the unparsed tail followed by the next chunk
+    // Characters after bufferend are zeroed for lookahead.
+    // @return false at EOF, with the window holding only the tail
+    bool next(const char*& pc, const char*& bufferend);
+
+    // total bytes read by the parser
+    long bytesRead() const;
+
+    // bytes copied to stitch tokens across chunks
+    long bytesStitched() const;
+
+    // did a failure of the compressed input end the input, once next() returns false
+    bool failed() const;
+
+    // failure of the compressed input, when failed()
+    const XMLError& failure() const;
+
+    static constexpr int CHUNK_SIZE = 16 * 16 * 4096;
+    static constexpr int STITCH_SIZE = 64 * 1024;
+    static constexpr int PADDING = 16;
+
+private:
+
+    // read chunks until EOF or stopped
+    void readChunks();
+
+    // chunk buffer with its stitch area
+    struct Chunk {
+        std::vector<char> data;
+        long length = 0;
+    };
+
+    static constexpr int NUM_CHUNKS = 4;
+
+    Chunk chunks[NUM_CHUNKS];
+
+    // overflow for tails too large for the stitch area
+    std::string overflow;
+
+    InputDecoder decoder;
+
+    // chunks filled by the reader, and released by the parser
+    long filled = 0;
+    long released = 0;
+    bool done = false;
+    bool readfailed = false;
+    bool stopping = false;
+    std::mutex mutex;
+    std::condition_variable changed;
+
+    // next chunk to parse, and the chunk being parsed, or -1 when parsing the overflow
+    long nextchunk = 0;
+    long current = -1;
+    long total = 0;
+    long stitched = 0;
+
+    std::thread reader;
+};
+
+#endif
@@ -0,0 +1,118 @@
+/*
+    ThreadPool.cpp
+
+    Implementation file for the work-stealing thread pool
+*/
+
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+// start the worker threads, 0 is one per hardware thread
+ThreadPool::ThreadPool(int threads) {
+
+    if (threads <= 0)
+        threads = std::max(1, (int) std::thread::hardware_concurrency());
+
+    for (int i = 0; i < threads; ++i)
+        queues.push_back(std::make_unique<Queue>());
+
+    for (int i = 0; i < threads; ++i)
+        this->threads.emplace_back(&ThreadPool::work, this, i);
+}
+
+// stop the worker threads
+ThreadPool::~ThreadPool() {
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    started.notify_all();
+    for (auto& thread : threads)
+        thread.join();
+}
+
+// number of worker threads
+int ThreadPool::size() const {
+
+    return (int) threads.size();
+}
+
+// run task(index, worker) for each index in [0, count), and wait for all to finish
+void ThreadPool::run(std::size_t count, const std::function<void(std::size_t index, int worker)>& task) {
+
+    // contiguous blocks of indices per worker, so neighboring tasks stay on one worker
+    const std::size_t workers = queues.size();
+    for (std::size_t worker = 0; worker < workers; ++worker) {
+        std::lock_guard<std::mutex> lock(queues[worker]->mutex);
+        for (std::size_t index = count * worker / workers; index < count * (worker + 1) / workers; ++index)
+            queues[worker]->indices.push_back(index);
+    }
+
+    // start all workers, and wait until all are idle again
+    std::unique_lock<std::mutex> lock(mutex);
+    this->task = &task;
+    active = (int) workers;
+    ++generation;
+    started.notify_all();
+    finished.wait(lock, [this]() { return active == 0; });
+    this->task = nullptr;
+}
+
+// worker loop
+void ThreadPool::work(int worker) {
+
+    long seen = 0;
+    while (true) {
+
+        // wait for a new run
+        const std::function<void(std::size_t, int)>* current = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            started.wait(lock, [this, seen]() { return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+            current = task;
+        }
+
+        // run tasks until none are left anywhere
+        std::size_t index;
+        while (take(worker, index))
+            (*current)(index, worker);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --active;
+        }
+        finished.notify_one();
+    }
+}
+
+// take a task index from the worker's own queue, or steal one
+bool ThreadPool::take(int worker, std::size_t& index) {
+
+    {
+        Queue& own = *queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.indices.empty()) {
+            index = own.indices.front();
+            own.indices.pop_front();
+            return true;
+        }
+    }
+
+    const int workers = (int) queues.size();
+    for (int i = 1; i < workers; ++i) {
+        Queue& victim = *queues[(worker + i) % workers];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.indices.empty()) {
+            index = victim.indices.back();
+            victim.indices.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
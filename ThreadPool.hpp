@@ -0,0 +1,65 @@
+/*
+    ThreadPool.hpp
+
+    Work-stealing thread pool. Each worker has its own queue of task
+    indices, takes from the front of it, and when empty steals from
+    the back of the other workers' queues.
+*/
+
+#ifndef INCLUDED_THREADPOOL_HPP
+#define INCLUDED_THREADPOOL_HPP
+
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+class ThreadPool {
+public:
+
+    // start the worker threads, 0 is one per hardware thread
+    ThreadPool(int threads = 0);
+
+    // stop the worker threads
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // number of worker threads
+    int size() const;
+
+    // run task(index, worker) for each index in [0, count), and wait for all to finish
+    void run(std::size_t count, const std::function<void(std::size_t index, int worker)>& task);
+
+private:
+
+    // worker loop
+    void work(int worker);
+
+    // take a task index from the worker's own queue, or steal one
+    bool take(int worker, std::size_t& index);
+
+    // queue of task indices for one worker
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::size_t> indices;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable started;
+    std::condition_variable finished;
+    const std::function<void(std::size_t, int)>* task = nullptr;
+    long generation = 0;
+    int active = 0;
+    bool stopping = false;
+};
+
+#endif
@@ -0,0 +1,103 @@
+/*
+    XMLAttributes.hpp
+
+    Attributes and namespace declarations of a start tag, in the order
+    of the tag, for handlers that take a start tag with all of them in
+    one event. Up to INLINE_CAPACITY are stored inline, so a typical tag
+    needs no allocation, and larger tags spill to the heap. The spill
+    keeps its capacity, so it is only allocated for the first large tag.
+
+    Views are into the parse buffer, and are only valid for the duration
+    of the start tag event.
+*/
+
+#ifndef INCLUDED_XMLATTRIBUTES_HPP
+#define INCLUDED_XMLATTRIBUTES_HPP
+
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+// attribute or namespace declaration of a start tag
+struct XMLAttribute {
+
+    // ID of the qualified name for the handler forms with IDs, otherwise -1
+    int id = -1;
+
+    // namespace ID for the handler form with namespace IDs, otherwise -1
+    int namespaceId = -1;
+
+    // for a namespace declaration, the local name is empty, the prefix is
+    // the declared prefix, and the value is the uri
+    std::string_view local_name;
+    std::string_view prefix;
+    std::string_view value;
+    bool isNamespace = false;
+};
+
+class XMLAttributes {
+public:
+
+    static constexpr std::size_t INLINE_CAPACITY = 16;
+
+    XMLAttributes() = default;
+
+    // items refers to the inline array
+    XMLAttributes(const XMLAttributes&) = delete;
+    XMLAttributes& operator=(const XMLAttributes&) = delete;
+
+    // number of attributes and namespace declarations
+    std::size_t size() const { return count; }
+
+    // are there no attributes or namespace declarations
+    bool empty() const { return count == 0; }
+
+    // attribute or namespace declaration in the order of the tag
+    const XMLAttribute& operator[](std::size_t index) const { return items[index]; }
+
+    XMLAttribute& operator[](std::size_t index) { return items[index]; }
+
+    const XMLAttribute* begin() const { return items; }
+
+    const XMLAttribute* end() const { return items + count; }
+
+    // attribute with the local name, or nullptr if there is none
+    const XMLAttribute* find(std::string_view local_name) const {
+
+        for (const XMLAttribute& attribute : *this)
+            if (!attribute.isNamespace && attribute.local_name == local_name)
+                return &attribute;
+
+        return nullptr;
+    }
+
+    // remove all, keeping any spill capacity
+    void clear() {
+
+        count = 0;
+        items = inlined;
+        spill.clear();
+    }
+
+    // add after the rest, spilling to the heap when the inline array is full
+    void push_back(const XMLAttribute& attribute) {
+
+        if (count < INLINE_CAPACITY) {
+            inlined[count++] = attribute;
+            return;
+        }
+        if (spill.empty())
+            spill.assign(inlined, inlined + count);
+        spill.push_back(attribute);
+        items = spill.data();
+        ++count;
+    }
+
+private:
+    XMLAttribute inlined[INLINE_CAPACITY];
+    std::vector<XMLAttribute> spill;
+    XMLAttribute* items = inlined;
+    std::size_t count = 0;
+};
+
+#endif
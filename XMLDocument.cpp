@@ -0,0 +1,284 @@
+/*
+    XMLDocument.cpp
+
+    Implementation file for the compact DOM
+*/
+
+#include "XMLDocument.hpp"
+#include "BasicXMLParser.hpp"
+
+#include <iostream>
+#include <cstdlib>
+
+// BasicXMLParser handler that appends nodes
+class XMLDocument::Builder {
+public:
+
+    // constructor
+    Builder(XMLDocument& document);
+
+    void handleDeclaration(std::string_view version, std::string_view encoding, std::string_view standalone);
+
+    void handleStartTag(int id, std::string_view local_name, std::string_view prefix);
+
+    void handleEndTag();
+
+    void handleAttribute(int id, std::string_view local_name, std::string_view value);
+
+    void handleNamespace(std::string_view uri, std::string_view prefix);
+
+    void handleCDATA(std::string_view characters);
+
+    void handleEntity(std::string_view characters);
+
+    void handleCharacters(std::string_view characters);
+
+    void handleComments(std::string_view comment);
+
+    // close any elements left open at the end of input, and the document
+    void finish();
+
+private:
+
+    // append a node with no children yet
+    std::uint32_t append(XMLNodeKind kind, std::uint32_t nameOrLength, std::uint32_t offset);
+
+    // append a leaf node with the text
+    void appendText(XMLNodeKind kind, std::string_view text);
+
+    // offset of the text, copying it to the extra text when not in the input
+    std::uint32_t offsetOf(std::string_view text);
+
+    XMLDocument& document;
+    std::vector<XMLNode>& nodes;
+
+    // open elements, with the document at the bottom
+    std::vector<std::uint32_t> open;
+
+    // offsets of single characters in the extra text, e.g., entity references
+    std::uint32_t characterOffsets[256];
+
+    // attribute value with its references decoded
+    std::string decoded;
+};
+
+// constructor
+XMLDocument::Builder::Builder(XMLDocument& document)
+    : document(document), nodes(document.nodes)
+{
+
+    for (std::uint32_t& offset : characterOffsets)
+        offset = NONE;
+
+    open.push_back(append(XMLNodeKind::Document, 0, 0));
+}
+
+// append a node with no children yet
+inline std::uint32_t XMLDocument::Builder::append(XMLNodeKind kind, std::uint32_t nameOrLength, std::uint32_t offset) {
+
+    const std::uint32_t index = (std::uint32_t) nodes.size();
+    if (index >= MAX_NODES) {
+        std::cerr << "XMLDocument error : Too many nodes for 28-bit indices\n";
+        exit(1);
+    }
+    XMLNode node;
+    node.parent = open.empty() ? NONE : open.back();
+    node.end = index + 1;
+    node.kind = (std::uint32_t) kind;
+    node.nameOrLength = nameOrLength;
+    node.offset = offset;
+    nodes.push_back(node);
+
+    return index;
+}
+
+// offset of the text, copying it to the extra text when not in the input
+inline std::uint32_t XMLDocument::Builder::offsetOf(std::string_view text) {
+
+    // text is in the input, except at the end of the input, which the parser copies
+    const std::uintptr_t start = (std::uintptr_t) text.data();
+    const std::uintptr_t first = (std::uintptr_t) document.input;
+    if (start >= first && start + text.size() <= first + document.inputSize)
+        return (std::uint32_t) (start - first);
+
+    // reuse single characters
+    if (text.size() == 1 && characterOffsets[(unsigned char) text[0]] != NONE)
+        return characterOffsets[(unsigned char) text[0]];
+
+    const std::size_t offset = document.inputSize + document.extra.size();
+    if (offset + text.size() >= NONE) {
+        std::cerr << "XMLDocument error : Input too large for 32-bit text offsets\n";
+        exit(1);
+    }
+    document.extra.append(text);
+    if (text.size() == 1)
+        characterOffsets[(unsigned char) text[0]] = (std::uint32_t) offset;
+
+    return (std::uint32_t) offset;
+}
+
+// append a leaf node with the text
+inline void XMLDocument::Builder::appendText(XMLNodeKind kind, std::string_view text) {
+
+    const std::uint32_t offset = offsetOf(text);
+
+    // extend the previous text when it is directly before in the input
+    if (kind == XMLNodeKind::Text && nodes.size() > open.back() + 1) {
+        XMLNode& last = nodes.back();
+        if ((XMLNodeKind) last.kind == XMLNodeKind::Text && last.parent == open.back()
+            && last.offset < document.inputSize && last.offset + last.nameOrLength == offset) {
+            last.nameOrLength += (std::uint32_t) text.size();
+            return;
+        }
+    }
+
+    append(kind, (std::uint32_t) text.size(), offset);
+}
+
+void XMLDocument::Builder::handleDeclaration(std::string_view version, std::string_view encoding, std::string_view standalone) {
+
+    document.declVersion = version;
+    document.declEncoding = encoding;
+    document.declStandalone = standalone;
+}
+
+inline void XMLDocument::Builder::handleStartTag(int id, std::string_view /* local_name */, std::string_view /* prefix */) {
+
+    open.push_back(append(XMLNodeKind::Element, (std::uint32_t) id, 0));
+}
+
+inline void XMLDocument::Builder::handleEndTag() {
+
+    nodes[open.back()].end = (std::uint32_t) nodes.size();
+    open.pop_back();
+}
+
+inline void XMLDocument::Builder::handleAttribute(int id, std::string_view /* local_name */, std::string_view value) {
+
+    open.push_back(append(XMLNodeKind::Attribute, (std::uint32_t) id, 0));
+    const std::string_view text = decodeXMLText(value, decoded);
+    append(XMLNodeKind::Text, (std::uint32_t) text.size(), offsetOf(text));
+    handleEndTag();
+}
+
+void XMLDocument::Builder::handleNamespace(std::string_view uri, std::string_view prefix) {
+
+    open.push_back(append(XMLNodeKind::Namespace, (std::uint32_t) document.nametable.intern(prefix), 0));
+    const std::string_view text = decodeXMLText(uri, decoded);
+    append(XMLNodeKind::Text, (std::uint32_t) text.size(), offsetOf(text));
+    handleEndTag();
+}
+
+inline void XMLDocument::Builder::handleCDATA(std::string_view characters) {
+
+    appendText(XMLNodeKind::CDATA, characters);
+}
+
+inline void XMLDocument::Builder::handleEntity(std::string_view characters) {
+
+    appendText(XMLNodeKind::Text, characters);
+}
+
+inline void XMLDocument::Builder::handleCharacters(std::string_view characters) {
+
+    appendText(XMLNodeKind::Text, characters);
+}
+
+inline void XMLDocument::Builder::handleComments(std::string_view comment) {
+
+    appendText(XMLNodeKind::Comment, comment);
+}
+
+// close any elements left open at the end of input, and the document
+void XMLDocument::Builder::finish() {
+
+    while (!open.empty())
+        handleEndTag();
+}
+
+// build from the file descriptor, in place when it is a regular file
+XMLDocument::XMLDocument(int fd)
+    : file(new MappedFile(fd))
+{
+
+    if (file->isMapped()) {
+        build(file->data(), file->size());
+    } else {
+        contents = readAll(fd);
+        build(contents.data(), contents.size());
+    }
+}
+
+// build from XML in memory, which must outlive the document
+XMLDocument::XMLDocument(const char* data, std::size_t len) {
+
+    build(data, len);
+}
+
+// build the nodes from the input
+void XMLDocument::build(const char* data, std::size_t len) {
+
+    if (len >= NONE) {
+        std::cerr << "XMLDocument error : Input too large for 32-bit text offsets\n";
+        exit(1);
+    }
+    input = data;
+    inputSize = len;
+
+    // typical markup has about one node for every 8 to 16 bytes, and reserving
+    // for the most avoids copying the arena as it grows. Any capacity past the
+    // last node is never touched, so it is address space, not memory.
+    nodes.reserve(len / 8 + 1);
+
+    Builder builder(*this);
+    BasicXMLParser<Builder> parser(builder, nametable);
+    parser.parse(data, len);
+    builder.finish();
+    totalBytes = parser.bytesRead();
+}
+
+// root element, or NONE
+std::uint32_t XMLDocument::root() const {
+
+    for (std::uint32_t node = firstChild(DOCUMENT); node != NONE; node = nextSibling(node))
+        if (kind(node) == XMLNodeKind::Element)
+            return node;
+
+    return NONE;
+}
+
+// XML declaration version
+const std::string& XMLDocument::version() const {
+
+    return declVersion;
+}
+
+// XML declaration encoding
+const std::string& XMLDocument::encoding() const {
+
+    return declEncoding;
+}
+
+// XML declaration standalone
+const std::string& XMLDocument::standalone() const {
+
+    return declStandalone;
+}
+
+// interned names
+const XMLNameTable& XMLDocument::names() const {
+
+    return nametable;
+}
+
+// total bytes of input
+long XMLDocument::bytesRead() const {
+
+    return totalBytes;
+}
+
+// bytes used by the nodes and the extra text, but not the input
+std::size_t XMLDocument::memoryUsed() const {
+
+    return nodes.size() * sizeof(XMLNode) + extra.size();
+}
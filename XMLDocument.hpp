@@ -0,0 +1,242 @@
+/*
+    XMLDocument.hpp
+
+    Compact DOM of an XML document, built with BasicXMLParser.
+
+    Nodes are stored in one contiguous arena in document order, with
+    the document node first. Since a node's descendants follow it
+    directly, each node only stores its parent and the end of its
+    subtree as indices, and the first child and next sibling
+    are derived from them. Each node is 16 bytes.
+
+    Attributes and namespace declarations are children of their
+    element, before its content. Their value is the single text child.
+
+        kind         name        text
+        Document
+        Element      name ID
+        Attribute    name ID
+        Namespace    prefix ID
+        Text                     characters, or an entity reference
+        CDATA                    characters
+        Comment                  comment
+
+    Names are interned IDs of names(). Text is an offset and length
+    into the input, the mapped file when there is one, and otherwise
+    a retained copy of the input. The few characters not in the
+    input, e.g., entity references and attribute values with them,
+    are decoded into a small extra buffer.
+
+    Limitations:
+    * Text offsets are 32-bit, so input must be under 4 GB
+    * Indices are 28-bit, so at most about 268 million nodes
+    * Whitespace is kept as text
+*/
+
+#ifndef INCLUDED_XMLDOCUMENT_HPP
+#define INCLUDED_XMLDOCUMENT_HPP
+
+#include "XMLNameTable.hpp"
+#include "MappedFile.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+// kind of DOM node
+enum class XMLNodeKind : std::uint8_t {
+    Document,
+    Element,
+    Attribute,
+    Namespace,
+    Text,
+    CDATA,
+    Comment
+};
+
+// DOM node
+struct XMLNode {
+
+    // index of the parent, or XMLDocument::NONE for the document
+    std::uint32_t parent;
+
+    // index after the last node of the subtree
+    std::uint32_t end : 28;
+    std::uint32_t kind : 4;
+
+    // name ID for elements, attributes, and namespaces
+    // length of the text for text, CDATA, and comments
+    std::uint32_t nameOrLength;
+
+    // offset of the text, after the input for extra text
+    std::uint32_t offset;
+};
+
+class XMLDocument {
+public:
+
+    // no node
+    static constexpr std::uint32_t NONE = 0xFFFFFFFF;
+
+    // index of the document node
+    static constexpr std::uint32_t DOCUMENT = 0;
+
+    // limit of the number of nodes, from the size of XMLNode::end
+    static constexpr std::uint32_t MAX_NODES = (1u << 28) - 1;
+
+    // build from the file descriptor, in place when it is a regular file
+    XMLDocument(int fd = 0);
+
+    // build from XML in memory, which must outlive the document
+    XMLDocument(const char* data, std::size_t len);
+
+    // text refers to the document
+    XMLDocument(const XMLDocument&) = delete;
+    XMLDocument& operator=(const XMLDocument&) = delete;
+
+    // number of nodes, including the document node
+    std::uint32_t size() const;
+
+    // root element, or NONE
+    std::uint32_t root() const;
+
+    // kind of the node
+    XMLNodeKind kind(std::uint32_t node) const;
+
+    // parent of the node, or NONE
+    std::uint32_t parent(std::uint32_t node) const;
+
+    // first child of the node, or NONE
+    std::uint32_t firstChild(std::uint32_t node) const;
+
+    // next sibling of the node, or NONE
+    std::uint32_t nextSibling(std::uint32_t node) const;
+
+    // name ID of an element, attribute, or namespace
+    int nameId(std::uint32_t node) const;
+
+    // local name of an element or attribute, or prefix of a namespace
+    std::string_view localName(std::uint32_t node) const;
+
+    // prefix of an element or attribute, empty if none
+    std::string_view prefix(std::uint32_t node) const;
+
+    // characters of a text, CDATA, or comment node
+    std::string_view text(std::uint32_t node) const;
+
+    // value of an attribute or namespace uri
+    std::string_view value(std::uint32_t node) const;
+
+    // XML declaration
+    const std::string& version() const;
+    const std::string& encoding() const;
+    const std::string& standalone() const;
+
+    // interned names
+    const XMLNameTable& names() const;
+
+    // total bytes of input
+    long bytesRead() const;
+
+    // bytes used by the nodes and the extra text, but not the input
+    std::size_t memoryUsed() const;
+
+private:
+
+    // BasicXMLParser handler that appends nodes
+    class Builder;
+
+    // build the nodes from the input
+    void build(const char* data, std::size_t len);
+
+    std::vector<XMLNode> nodes;
+    XMLNameTable nametable;
+
+    // input, and the text not in it
+    const char* input = nullptr;
+    std::size_t inputSize = 0;
+    std::string extra;
+
+    // owner of the input when it is not the caller's
+    std::unique_ptr<MappedFile> file;
+    std::string contents;
+
+    std::string declVersion;
+    std::string declEncoding;
+    std::string declStandalone;
+    long totalBytes = 0;
+};
+
+// number of nodes, including the document node
+inline std::uint32_t XMLDocument::size() const {
+
+    return (std::uint32_t) nodes.size();
+}
+
+// kind of the node
+inline XMLNodeKind XMLDocument::kind(std::uint32_t node) const {
+
+    return (XMLNodeKind) nodes[node].kind;
+}
+
+// parent of the node, or NONE
+inline std::uint32_t XMLDocument::parent(std::uint32_t node) const {
+
+    return nodes[node].parent;
+}
+
+// first child of the node, or NONE
+inline std::uint32_t XMLDocument::firstChild(std::uint32_t node) const {
+
+    return nodes[node].end > node + 1 ? node + 1 : NONE;
+}
+
+// next sibling of the node, or NONE
+inline std::uint32_t XMLDocument::nextSibling(std::uint32_t node) const {
+
+    const std::uint32_t up = nodes[node].parent;
+    if (up == NONE)
+        return NONE;
+
+    const std::uint32_t next = nodes[node].end;
+    return next < nodes[up].end ? next : NONE;
+}
+
+// name ID of an element, attribute, or namespace
+inline int XMLDocument::nameId(std::uint32_t node) const {
+
+    return (int) nodes[node].nameOrLength;
+}
+
+// local name of an element or attribute, or prefix of a namespace
+inline std::string_view XMLDocument::localName(std::uint32_t node) const {
+
+    return nametable.localName(nameId(node));
+}
+
+// prefix of an element or attribute, empty if none
+inline std::string_view XMLDocument::prefix(std::uint32_t node) const {
+
+    return nametable.prefix(nameId(node));
+}
+
+// characters of a text, CDATA, or comment node
+inline std::string_view XMLDocument::text(std::uint32_t node) const {
+
+    const XMLNode& current = nodes[node];
+    if (current.offset < inputSize)
+        return std::string_view(input + current.offset, current.nameOrLength);
+
+    return std::string_view(extra.data() + (current.offset - inputSize), current.nameOrLength);
+}
+
+// value of an attribute or namespace uri
+inline std::string_view XMLDocument::value(std::uint32_t node) const {
+
+    return text(node + 1);
+}
+
+#endif
@@ -0,0 +1,65 @@
+/*
+    XMLError.hpp
+
+    Parse errors, for handlers that recover from them. A handler that
+    declares handleError() is given each error, and parsing resumes at
+    the next top-level unit. Without it, the parser reports the error
+    and exits.
+
+    The offset is in bytes from the start of the input given to the
+    parser, e.g., of a fragment, and for compressed input, of the
+    decompressed input. The line and column are only counted
+    when an error happens, from the input in memory. For streamed input
+    the earlier bytes are gone, so they are 0.
+*/
+
+#ifndef INCLUDED_XMLERROR_HPP
+#define INCLUDED_XMLERROR_HPP
+
+#include <string>
+#include <ostream>
+
+// kind of parse error
+enum class XMLErrorKind {
+    Declaration,            // malformed XML declaration
+    StartTag,               // incomplete or unterminated start tag
+    EndTag,                 // incomplete end tag
+    Attribute,              // malformed attribute
+    Namespace,              // malformed namespace declaration
+    CDATA,                  // unterminated CDATA section
+    Comment,                // unterminated comment
+    Content,                // characters where a start tag is expected
+    Markup,                 // incomplete markup in a skipped element
+    Compression,            // corrupt, truncated, or unsupported compressed input
+    Name,                   // invalid name characters, when checking well-formedness
+    DuplicateAttribute,     // attribute repeated in a start tag, when checking
+    MismatchedEndTag,       // end tag not of the open element, when checking
+    UnclosedElement,        // element open at the end of input, when checking
+    Root,                   // no root element, or more than one, when checking
+};
+
+// parse error with its location
+struct XMLError {
+    XMLErrorKind kind = XMLErrorKind::Content;
+
+    // byte offset from the start of the input
+    long offset = 0;
+
+    // line and column from 1, in bytes, or 0 when not known
+    long line = 0;
+    long column = 0;
+
+    std::string message;
+};
+
+// message with its location, the line and column when known, otherwise the byte offset
+inline std::ostream& operator<<(std::ostream& out, const XMLError& error) {
+
+    out << error.message;
+    if (error.line != 0)
+        return out << " at line " << error.line << ", column " << error.column;
+
+    return out << " at byte " << error.offset;
+}
+
+#endif
@@ -0,0 +1,55 @@
+/*
+    XMLNameTable.cpp
+
+    Implementation file for the symbol table of XML qualified names.
+    Lookup is open addressing with linear probing, and is inline in the
+    header. Only adding a new name is here.
+*/
+
+#include "XMLNameTable.hpp"
+
+// initial number of slots, a power of 2
+static const std::size_t INITIAL_SLOTS = 1024;
+
+// constructor
+XMLNameTable::XMLNameTable()
+    : slots(INITIAL_SLOTS, -1)
+{
+
+    entries.reserve(INITIAL_SLOTS / 2);
+}
+
+// add a new name with the hash
+int XMLNameTable::insert(std::string_view qname, std::uint32_t namehash) {
+
+    // keep the load factor at most 1/2
+    if ((entries.size() + 1) * 2 > slots.size())
+        grow();
+
+    storage.emplace_back(qname);
+    const std::string_view name = storage.back();
+    const auto colonpos = name.find(':');
+    const int id = (int) entries.size();
+    entries.push_back({ name, namehash, colonpos != std::string_view::npos ? (std::uint32_t) colonpos + 1 : 0 });
+
+    const std::size_t mask = slots.size() - 1;
+    std::size_t slot = namehash & mask;
+    while (slots[slot] != -1)
+        slot = (slot + 1) & mask;
+    slots[slot] = id;
+
+    return id;
+}
+
+// double the slots, and rehash the names
+void XMLNameTable::grow() {
+
+    slots.assign(slots.size() * 2, -1);
+    const std::size_t mask = slots.size() - 1;
+    for (int id = 0; id < (int) entries.size(); ++id) {
+        std::size_t slot = entries[id].hash & mask;
+        while (slots[slot] != -1)
+            slot = (slot + 1) & mask;
+        slots[slot] = id;
+    }
+}
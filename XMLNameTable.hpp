@@ -0,0 +1,118 @@
+/*
+    XMLNameTable.hpp
+
+    Symbol table of XML qualified names. Each distinct qname, e.g.,
+    of an element or an attribute, is interned once and given a small
+    integer ID. IDs are dense, starting at 0, in order of first use.
+*/
+
+#ifndef INCLUDED_XMLNAMETABLE_HPP
+#define INCLUDED_XMLNAMETABLE_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <cstdint>
+
+class XMLNameTable {
+public:
+
+    // constructor
+    XMLNameTable();
+
+    // ID of the qualified name, interning it if new
+    int intern(std::string_view qname);
+
+    // number of interned names
+    int size() const;
+
+    // qualified name of the ID
+    std::string_view qname(int id) const;
+
+    // prefix of the ID, empty if none
+    std::string_view prefix(int id) const;
+
+    // local name of the ID
+    std::string_view localName(int id) const;
+
+private:
+
+    // hash of the name
+    static std::uint32_t hash(std::string_view name);
+
+    // add a new name with the hash
+    int insert(std::string_view qname, std::uint32_t namehash);
+
+    // double the slots, and rehash the names
+    void grow();
+
+    struct Entry {
+        std::string_view qname;
+        std::uint32_t hash;
+        // start of the local name, after the prefix and colon
+        std::uint32_t localstart;
+    };
+
+    // slot holds an ID, or -1 when empty
+    std::vector<int> slots;
+    std::vector<Entry> entries;
+
+    // storage for the names, which never moves
+    std::deque<std::string> storage;
+};
+
+// hash of the name
+inline std::uint32_t XMLNameTable::hash(std::string_view name) {
+
+    // FNV-1a
+    std::uint32_t value = 2166136261u;
+    for (const char c : name) {
+        value ^= (unsigned char) c;
+        value *= 16777619u;
+    }
+
+    return value;
+}
+
+// ID of the qualified name, interning it if new
+inline int XMLNameTable::intern(std::string_view qname) {
+
+    const std::uint32_t namehash = hash(qname);
+    const std::size_t mask = slots.size() - 1;
+    for (std::size_t slot = namehash & mask; ; slot = (slot + 1) & mask) {
+        const int id = slots[slot];
+        if (id == -1)
+            return insert(qname, namehash);
+        const Entry& entry = entries[id];
+        if (entry.hash == namehash && entry.qname == qname)
+            return id;
+    }
+}
+
+// number of interned names
+inline int XMLNameTable::size() const {
+
+    return (int) entries.size();
+}
+
+// qualified name of the ID
+inline std::string_view XMLNameTable::qname(int id) const {
+
+    return entries[id].qname;
+}
+
+// prefix of the ID, empty if none
+inline std::string_view XMLNameTable::prefix(int id) const {
+
+    const Entry& entry = entries[id];
+    return entry.qname.substr(0, entry.localstart != 0 ? entry.localstart - 1 : 0);
+}
+
+// local name of the ID
+inline std::string_view XMLNameTable::localName(int id) const {
+
+    return entries[id].qname.substr(entries[id].localstart);
+}
+
+#endif
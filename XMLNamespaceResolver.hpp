@@ -0,0 +1,147 @@
+/*
+    XMLNamespaceResolver.hpp
+
+    Scoped resolution of namespace prefixes. The namespace ID of a uri
+    is its ID in the name table, so a handler can intern a known uri
+    once and compare IDs. Prefixes are interned in the same table.
+
+    Declarations are bound to the depth of their element, and a stack
+    of the bindings they replace restores them at the end of the element.
+    The current binding of each prefix, and the prefix of each qualified
+    name, are arrays indexed by ID, so resolving a name is two array
+    indexes once it has been seen.
+
+    Elements without a prefix are in the default namespace, attributes
+    without a prefix are in no namespace, and the prefix xml is always
+    bound. An undeclared prefix, or an xmlns="" default, is NONE.
+*/
+
+#ifndef INCLUDED_XMLNAMESPACERESOLVER_HPP
+#define INCLUDED_XMLNAMESPACERESOLVER_HPP
+
+#include "XMLNameTable.hpp"
+
+#include <string_view>
+#include <vector>
+
+class XMLNamespaceResolver {
+public:
+
+    // no namespace
+    static constexpr int NONE = -1;
+
+    // resolve with the names and uris interned in the table, after reset()
+    XMLNamespaceResolver(XMLNameTable& names);
+
+    // start a document, with only the prefix xml bound
+    void reset();
+
+    // bind the prefix, empty for the default namespace, to the uri in the element at the depth
+    void bind(std::string_view prefix, std::string_view uri, int depth);
+
+    // restore the bindings replaced in the element at the depth
+    void endElement(int depth);
+
+    // namespace ID of the element with the qualified name ID
+    int element(int id);
+
+    // namespace ID of the attribute with the qualified name ID
+    int attribute(int id);
+
+private:
+
+    // prefix ID of the qualified name ID
+    int prefixOf(int id);
+
+    // namespace ID bound to the prefix ID
+    int boundTo(int prefix) const;
+
+    XMLNameTable& names;
+
+    // ID of the empty prefix
+    int defaultPrefix = NONE;
+
+    // namespace ID of each prefix ID, or NONE
+    std::vector<int> bound;
+
+    // prefix ID of each qualified name ID, or UNCACHED
+    static constexpr int UNCACHED = -2;
+    std::vector<int> prefixes;
+
+    // bindings replaced by declarations in open elements
+    struct Binding {
+        int prefix;
+        int previous;
+        int depth;
+    };
+    std::vector<Binding> bindings;
+};
+
+// resolve with the names and uris interned in the table, after reset()
+inline XMLNamespaceResolver::XMLNamespaceResolver(XMLNameTable& names)
+    : names(names)
+{}
+
+// start a document, with only the prefix xml bound
+inline void XMLNamespaceResolver::reset() {
+
+    // nothing is interned until a document is resolved
+    defaultPrefix = names.intern("");
+    bound.assign(bound.size(), NONE);
+    bindings.clear();
+    bind("xml", "http://www.w3.org/XML/1998/namespace", 0);
+    bindings.clear();
+}
+
+// bind the prefix, empty for the default namespace, to the uri in the element at the depth
+inline void XMLNamespaceResolver::bind(std::string_view prefix, std::string_view uri, int depth) {
+
+    const int prefixId = names.intern(prefix);
+    if ((std::size_t) prefixId >= bound.size())
+        bound.resize(names.size(), NONE);
+    bindings.push_back({ prefixId, bound[prefixId], depth });
+    bound[prefixId] = uri.empty() ? NONE : names.intern(uri);
+}
+
+// restore the bindings replaced in the element at the depth
+inline void XMLNamespaceResolver::endElement(int depth) {
+
+    while (!bindings.empty() && bindings.back().depth >= depth) {
+        bound[bindings.back().prefix] = bindings.back().previous;
+        bindings.pop_back();
+    }
+}
+
+// namespace ID of the element with the qualified name ID
+inline int XMLNamespaceResolver::element(int id) {
+
+    return boundTo(prefixOf(id));
+}
+
+// namespace ID of the attribute with the qualified name ID
+inline int XMLNamespaceResolver::attribute(int id) {
+
+    const int prefix = prefixOf(id);
+    return prefix != defaultPrefix ? boundTo(prefix) : NONE;
+}
+
+// prefix ID of the qualified name ID
+inline int XMLNamespaceResolver::prefixOf(int id) {
+
+    if ((std::size_t) id >= prefixes.size())
+        prefixes.resize(names.size(), UNCACHED);
+    if (prefixes[id] == UNCACHED) {
+        const std::string_view prefix = names.prefix(id);
+        prefixes[id] = names.intern(prefix);
+    }
+
+    return prefixes[id];
+}
+
+// namespace ID bound to the prefix ID
+inline int XMLNamespaceResolver::boundTo(int prefix) const {
+
+    return (std::size_t) prefix < bound.size() ? bound[prefix] : NONE;
+}
+
+#endif
@@ -2,117 +2,160 @@
     XMLParser.hpp
 
     Decleration file for XML parsing class
+
+    Adapter of std::function callbacks over BasicXMLParser.
 */
 
 #ifndef INCLUDED_XMLPARSER_HPP
 #define INCLUDED_XMLPARSER_HPP
 
+#include "BasicXMLParser.hpp"
+
 #include <string>
+#include <string_view>
 #include <functional>
+#include <memory>
+
+// zero-copy event callbacks
+// Names, prefixes, values, and characters are views into the parse buffer
+// and are only valid for the duration of the callback.
+struct XMLViewHandlers {
+    std::function<void(std::string_view version, std::string_view encoding, std::string_view standalone)> handleDeclaration;
+    std::function<void(std::string_view local_name, std::string_view prefix)> handleStartTag;
+    std::function<void(std::string_view local_name, std::string_view prefix)> handleEndTag;
+    std::function<void(std::string_view local_name, std::string_view value)> handleAttribute;
+    std::function<void(std::string_view uri, std::string_view prefix)> handleNamespace;
+    std::function<void(std::string_view characters)> handleCDATA;
+    std::function<void(std::string_view characters)> handleEntity;
+    std::function<void(std::string_view characters)> handleCharacters;
+    std::function<void(std::string_view comment)> handleComments;
+
+    // without it, an error is reported and the program exits, and the open elements are not tracked
+    std::function<XMLControl(const XMLError& error)> handleError;
+};
 
-class XMLParser {
+// BasicXMLParser handler that forwards each event to its callback, if any
+// The forwarding is inline, so an event with no callback costs only the check.
+class XMLFunctionHandler {
 public:
 
     // constructor
-    XMLParser(std::function<void(const std::string&, const std::string&, const std::string&)> handleDeclaration,
-              std::function<void(const std::string&, const std::string&)> handleStartTag,
-              std::function<void(const std::string&, const std::string&)> handleEndTag,
-              std::function<void(const std::string&, const std::string&)> handleAttribute,
-              std::function<void(const std::string&, const std::string&)> handleNamespace,
-              std::function<void(const std::string&, const long&)> handleCDATA,
-              std::function<void(const std::string&, const long&)> handleEntity,
-              std::function<void(const std::string&, const char&)> handleCharacters,
-              std::function<void()> handleComments);
+    XMLFunctionHandler(XMLViewHandlers handlers);
 
-    // parse XML
-    void parse(long& total, std::string& characters, std::string& value, std::string& local_name);
+    // forward XML declaration
+    void handleDeclaration(std::string_view version, std::string_view encoding, std::string_view standalone) {
+
+        if (handlers.handleDeclaration != nullptr)
+            handlers.handleDeclaration(version, encoding, standalone);
+    }
+
+    // forward start tag, then its attributes and namespaces in the order of the tag
+    void handleStartTag(std::string_view local_name, std::string_view prefix, const XMLAttributes& attributes) {
+
+        if (handlers.handleStartTag != nullptr)
+            handlers.handleStartTag(local_name, prefix);
+        if (handlers.handleAttribute == nullptr && handlers.handleNamespace == nullptr)
+            return;
+        for (const XMLAttribute& attribute : attributes) {
+            if (!attribute.isNamespace && handlers.handleAttribute != nullptr)
+                handlers.handleAttribute(attribute.local_name, attribute.value);
+            else if (attribute.isNamespace && handlers.handleNamespace != nullptr)
+                handlers.handleNamespace(attribute.value, attribute.prefix);
+        }
+    }
 
-    // does buffer need refilled
-    bool needRefill();
+    // forward end tag
+    void handleEndTag(std::string_view local_name, std::string_view prefix) {
 
-    // is done parsing
-    bool isDone();
+        if (handlers.handleEndTag != nullptr)
+            handlers.handleEndTag(local_name, prefix);
+    }
 
-    // check if declaration
-    bool isXMLDeclaration();
+    // forward CDATA
+    void handleCDATA(std::string_view characters) {
 
-    // check if end tag
-    bool isXMLEndTag();
+        if (handlers.handleCDATA != nullptr)
+            handlers.handleCDATA(characters);
+    }
 
-    // check if start tag
-    bool isXMLStartTag();
+    // forward entity
+    void handleEntity(std::string_view characters) {
 
-    // check if namespace
-    bool isXMLNamespace();
+        if (handlers.handleEntity != nullptr)
+            handlers.handleEntity(characters);
+    }
 
-    // check if attribute
-    bool isXMLAttribute();
+    // forward characters
+    void handleCharacters(std::string_view characters) {
 
-    // check if CDATA
-    bool isXMLCData();
+        if (handlers.handleCharacters != nullptr)
+            handlers.handleCharacters(characters);
+    }
 
-    // check if comment
-    bool isXMLComment();
+    // forward comment
+    void handleComments(std::string_view comment) {
 
-    // check if characters before XML
-    bool isBeforeXML();
+        if (handlers.handleComments != nullptr)
+            handlers.handleComments(comment);
+    }
 
-    // check if entity
-    bool isXMLEntity();
+    // is there an error callback
+    bool recovers() const {
 
-    // check if characters
-    bool isXMLCharacters();
+        return handlers.handleError != nullptr;
+    }
 
-    // refill buffer 
-    void refill(long& total);
+protected:
+    XMLViewHandlers handlers;
+};
 
-    // parse xml declaration
-    void parseXMLDeclaration(long& total);
+// XMLFunctionHandler that also forwards errors, so the parser recovers from them
+// Only used when there is an error callback, as recovery tracks the open elements.
+class XMLErrorFunctionHandler : public XMLFunctionHandler {
+public:
 
-    // parse xml end tag
-    void parseXMLEndTag(long& total);
+    using XMLFunctionHandler::XMLFunctionHandler;
 
-    // parse xml start tag
-    void parseXMLStartTag(long& total, std::string& local_name);
+    // forward error
+    XMLControl handleError(const XMLError& error) {
 
-    // parse xml namespace
-    void parseXMLNamespace();
+        return handlers.handleError(error);
+    }
+};
 
-    // parse xml attribute
-    void parseXMLAttribute(std::string& local_name, std::string& value);
+class XMLParser {
+public:
 
-    // parse xml CDATA
-    void parseXMLCDATA(std::string& characters, long& total);
+    // constructor
+    XMLParser(std::function<void(const std::string&, const std::string&, const std::string&)> handleDeclaration,
+              std::function<void(const std::string&, const std::string&)> handleStartTag,
+              std::function<void(const std::string&, const std::string&)> handleEndTag,
+              std::function<void(const std::string&, const std::string&)> handleAttribute,
+              std::function<void(const std::string&, const std::string&)> handleNamespace,
+              std::function<void(const std::string&, const long&)> handleCDATA,
+              std::function<void(const std::string&, const long&)> handleEntity,
+              std::function<void(const std::string&, const char&)> handleCharacters,
+              std::function<void()> handleComments);
 
-    // parse xml comment
-    void parseXMLComment(long total);
+    // constructor with zero-copy callbacks
+    XMLParser(XMLViewHandlers handlers);
 
-    // parse characters before xml
-    void parseBeforeXML();
+    // handlers may refer to the parser
+    XMLParser(const XMLParser&) = delete;
+    XMLParser& operator=(const XMLParser&) = delete;
 
-    // parse xml entity reference
-    void parseXMLEntity(long total, std::string& characters);
+    // parse XML
+    void parse(long& total);
 
-    // parse xml characters
-    void parseXMLCharacters(std::string& characters);
+    // parse XML, strings are unused and kept for compatibility
+    void parse(long& total, std::string& characters, std::string& value, std::string& local_name);
 
 private:
-    std::function<void(const std::string&, const std::string&, const std::string&)> handleDeclaration;
-    std::function<void(const std::string&, const std::string&)> handleStartTag;
-    std::function<void(const std::string&, const std::string&)> handleEndTag;
-    std::function<void(const std::string&, const std::string&)> handleAttribute;
-    std::function<void(const std::string&, const std::string&)> handleNamespace;
-    std::function<void(const std::string&, const long&)> handleCDATA;
-    std::function<void(const std::string&, const long&)> handleEntity;
-    std::function<void(const std::string&, const char&)> handleCharacters;
-    std::function<void()> handleComments;
-
-    bool intag = false;
-    std::string buffer;
-    std::string::const_iterator pc;
-    std::string::const_iterator pnameend;
-    std::string::const_iterator pvalueend;
-    int depth = 0;
+    XMLErrorFunctionHandler handler;
+    BasicXMLParser<XMLFunctionHandler> parser;
+
+    // parser used instead when there is an error callback
+    std::unique_ptr<BasicXMLParser<XMLErrorFunctionHandler>> recoveringParser;
 };
 
 #endif
@@ -0,0 +1,130 @@
+/*
+    XMLParserStats.hpp
+
+    Opt-in instrumentation of BasicXMLParser. Built with XML_PARSER_STATS,
+    e.g., cmake -DXML_PARSER_STATS=ON, each parse step is counted and
+    timed by the kind of event it parsed, with the bytes it consumed.
+    Refills are counted with the bytes of the unparsed tail they move,
+    and the refills in the middle of a token, i.e., the partial tokens
+    that span a refill.
+
+    Without XML_PARSER_STATS the parser does not update the stats, so
+    the instrumentation has no cost.
+*/
+
+#ifndef INCLUDED_XMLPARSERSTATS_HPP
+#define INCLUDED_XMLPARSERSTATS_HPP
+
+#include <ostream>
+#include <cstdint>
+#include <chrono>
+#include <cmath>
+
+#if defined(XML_PARSER_STATS) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#elif defined(XML_PARSER_STATS) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+struct XMLParserStats {
+
+    // is the parser instrumented
+#if defined(XML_PARSER_STATS)
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+
+    // kind of parse step
+    enum Kind {
+        None,
+        Declaration,
+        StartTag,
+        EndTag,
+        Namespace,
+        Attribute,
+        CDATA,
+        Comment,
+        BeforeXML,
+        Entity,
+        Characters,
+        Refill,
+        Skip,
+        KINDS
+    };
+
+    // name of the kind of parse step
+    static const char* name(int kind) {
+
+        static const char* const names[KINDS] = {
+            "none", "declaration", "start tag", "end tag", "namespace", "attribute", "CDATA",
+            "comment", "before XML", "entity", "characters", "refill", "skip",
+        };
+
+        return names[kind];
+    }
+
+    // ticks of the cycle counter, or nanoseconds where there is none
+    static std::uint64_t now() {
+
+#if defined(XML_PARSER_STATS) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+        return __rdtsc();
+#else
+        return (std::uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // add a parse step
+    void add(Kind kind, std::uint64_t stepTicks, long stepBytes) {
+
+        ++count[kind];
+        ticks[kind] += stepTicks;
+        bytes[kind] += stepBytes;
+    }
+
+    // add the stats of another parser
+    XMLParserStats& operator+=(const XMLParserStats& other) {
+
+        for (int kind = 0; kind < KINDS; ++kind) {
+            count[kind] += other.count[kind];
+            ticks[kind] += other.ticks[kind];
+            bytes[kind] += other.bytes[kind];
+        }
+        refills += other.refills;
+        tailBytes += other.tailBytes;
+        partialTokens += other.partialTokens;
+
+        return *this;
+    }
+
+    // Markdown report of the breakdown
+    void report(std::ostream& out) const {
+
+        std::uint64_t totalTicks = 0;
+        for (int kind = 1; kind < KINDS; ++kind)
+            totalTicks += ticks[kind];
+
+        out << "| Parse step | Count | Bytes | Ticks | Ticks/step | Ticks % |\n";
+        out << "|:-----|-----:|-----:|-----:|-----:|-----:|\n";
+        for (int kind = 1; kind < KINDS; ++kind) {
+            if (count[kind] == 0)
+                continue;
+            out << "| " << name(kind) << " | " << count[kind] << " | " << bytes[kind] << " | " << ticks[kind]
+                << " | " << ticks[kind] / (std::uint64_t) count[kind]
+                << " | " << (totalTicks != 0 ? std::round(1000.0 * (double) ticks[kind] / (double) totalTicks) / 10.0 : 0.0) << " |\n";
+        }
+        out << "| refills | " << refills << " | | | | |\n";
+        out << "| tail bytes moved | " << tailBytes << " | | | | |\n";
+        out << "| partial tokens | " << partialTokens << " | | | | |\n";
+    }
+
+    long count[KINDS] = {};
+    std::uint64_t ticks[KINDS] = {};
+    long bytes[KINDS] = {};
+    long refills = 0;
+    long tailBytes = 0;
+    long partialTokens = 0;
+};
+
+#endif
@@ -0,0 +1,42 @@
+/*
+    XMLReader.cpp
+
+    Implementation file for the pull-style XML reader
+*/
+
+#include "XMLReader.hpp"
+
+// read XML from the file descriptor, in place when it is a regular file
+XMLReader::XMLReader(int fd)
+    : parser(handler), file(new MappedFile(fd))
+{
+
+    handler.names = &parser.names();
+    if (file->isMapped()) {
+        parser.beginInput(file->data(), file->size());
+    } else {
+        input.reset(new ReadAhead(fd));
+        parser.beginInput(*input);
+    }
+}
+
+// read XML document in memory
+XMLReader::XMLReader(const char* data, std::size_t len)
+    : parser(handler)
+{
+
+    handler.names = &parser.names();
+    parser.beginInput(data, len);
+}
+
+// interned names, with the IDs of the tokens
+const XMLNameTable& XMLReader::names() const {
+
+    return parser.names();
+}
+
+// total bytes read so far
+long XMLReader::bytesRead() const {
+
+    return parser.bytesRead();
+}
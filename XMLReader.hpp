@@ -0,0 +1,251 @@
+/*
+    XMLReader.hpp
+
+    Pull-style XML reader. Instead of the parser calling handlers, the
+    caller asks for each token with next(), so the parse can be driven
+    from the caller's own loop or state machine, stopped at any point,
+    or looked ahead one token with peek(). The tokenizer is the same
+    BasicXMLParser used by parse().
+
+    Parts of each token kind:
+
+        kind         name        prefix      value
+        Declaration  encoding    standalone  version
+        StartTag     local name  prefix
+        EndTag       local name  prefix
+        Attribute    local name  prefix      value
+        Namespace                prefix      uri
+        CDATA                                characters
+        Entity                               characters
+        Characters                           characters
+        Comment                              comment
+        End
+
+    Views are into the parse buffer, and are only valid until the next
+    call of next() or peek().
+
+    Entity values are the decoded UTF-8 characters. Attribute values are
+    as in the input, and decodeXMLText() gives the decoded value.
+*/
+
+#ifndef INCLUDED_XMLREADER_HPP
+#define INCLUDED_XMLREADER_HPP
+
+#include "BasicXMLParser.hpp"
+#include "XMLNameTable.hpp"
+#include "ReadAhead.hpp"
+#include "MappedFile.hpp"
+
+#include <string_view>
+#include <memory>
+
+// kind of XML token
+enum class XMLTokenKind {
+    Declaration,
+    StartTag,
+    EndTag,
+    Attribute,
+    Namespace,
+    CDATA,
+    Entity,
+    Characters,
+    Comment,
+    End
+};
+
+// XML token with views of its parts
+struct XMLToken {
+    XMLTokenKind kind = XMLTokenKind::End;
+    std::string_view name;
+    std::string_view prefix;
+    std::string_view value;
+
+    // depth of the element the token is in, or of the element for tags
+    int depth = 0;
+
+    // name ID of tags and attributes, else -1
+    int id = -1;
+};
+
+class XMLReader {
+public:
+
+    // read XML from the file descriptor, in place when it is a regular file
+    XMLReader(int fd = 0);
+
+    // read XML document in memory
+    XMLReader(const char* data, std::size_t len);
+
+    // tokens refer to the reader
+    XMLReader(const XMLReader&) = delete;
+    XMLReader& operator=(const XMLReader&) = delete;
+
+    // move to the next token, of kind End after all input
+    const XMLToken& next();
+
+    // token after the current one, without moving to it
+    // Views of the current token may not be valid after the call.
+    const XMLToken& peek();
+
+    // interned names, with the IDs of the tokens
+    const XMLNameTable& names() const;
+
+    // total bytes read so far
+    long bytesRead() const;
+
+private:
+
+    // BasicXMLParser handler that queues tokens
+    class TokenHandler {
+    public:
+
+        void handleDeclaration(std::string_view version, std::string_view encoding, std::string_view standalone);
+
+        void handleStartTag(int id, std::string_view local_name, std::string_view prefix);
+
+        void handleEndTag(int id, std::string_view local_name, std::string_view prefix);
+
+        void handleAttribute(int id, std::string_view local_name, std::string_view value);
+
+        void handleNamespace(std::string_view uri, std::string_view prefix);
+
+        void handleCDATA(std::string_view characters);
+
+        void handleEntity(std::string_view characters);
+
+        void handleCharacters(std::string_view characters);
+
+        void handleComments(std::string_view comment);
+
+        // add a token of the kind to the queue
+        XMLToken& push(XMLTokenKind kind);
+
+        // at most two tokens, an empty element, are queued by one parse step,
+        // so the current token is kept while peeking
+        static constexpr int QUEUE_SIZE = 4;
+        XMLToken queue[QUEUE_SIZE];
+        int head = 0;
+        int count = 0;
+        int depth = 0;
+        const XMLNameTable* names = nullptr;
+    };
+
+    // parse until a token is queued
+    // @return false at the end of input
+    bool fill();
+
+    TokenHandler handler;
+    BasicXMLParser<TokenHandler> parser;
+    std::unique_ptr<MappedFile> file;
+    std::unique_ptr<ReadAhead> input;
+    XMLToken end;
+};
+
+// add a token of the kind to the queue
+inline XMLToken& XMLReader::TokenHandler::push(XMLTokenKind kind) {
+
+    XMLToken& token = queue[(head + count) % QUEUE_SIZE];
+    ++count;
+    token = XMLToken();
+    token.kind = kind;
+    token.depth = depth;
+
+    return token;
+}
+
+inline void XMLReader::TokenHandler::handleDeclaration(std::string_view version, std::string_view encoding, std::string_view standalone) {
+
+    XMLToken& token = push(XMLTokenKind::Declaration);
+    token.name = encoding;
+    token.prefix = standalone;
+    token.value = version;
+}
+
+inline void XMLReader::TokenHandler::handleStartTag(int id, std::string_view local_name, std::string_view prefix) {
+
+    ++depth;
+    XMLToken& token = push(XMLTokenKind::StartTag);
+    token.name = local_name;
+    token.prefix = prefix;
+    token.id = id;
+}
+
+inline void XMLReader::TokenHandler::handleEndTag(int id, std::string_view local_name, std::string_view prefix) {
+
+    XMLToken& token = push(XMLTokenKind::EndTag);
+    token.name = local_name;
+    token.prefix = prefix;
+    token.id = id;
+    --depth;
+}
+
+inline void XMLReader::TokenHandler::handleAttribute(int id, std::string_view local_name, std::string_view value) {
+
+    XMLToken& token = push(XMLTokenKind::Attribute);
+    token.name = local_name;
+    token.prefix = names->prefix(id);
+    token.value = value;
+    token.id = id;
+}
+
+inline void XMLReader::TokenHandler::handleNamespace(std::string_view uri, std::string_view prefix) {
+
+    XMLToken& token = push(XMLTokenKind::Namespace);
+    token.prefix = prefix;
+    token.value = uri;
+}
+
+inline void XMLReader::TokenHandler::handleCDATA(std::string_view characters) {
+
+    push(XMLTokenKind::CDATA).value = characters;
+}
+
+inline void XMLReader::TokenHandler::handleEntity(std::string_view characters) {
+
+    push(XMLTokenKind::Entity).value = characters;
+}
+
+inline void XMLReader::TokenHandler::handleCharacters(std::string_view characters) {
+
+    push(XMLTokenKind::Characters).value = characters;
+}
+
+inline void XMLReader::TokenHandler::handleComments(std::string_view comment) {
+
+    push(XMLTokenKind::Comment).value = comment;
+}
+
+// parse until a token is queued
+inline bool XMLReader::fill() {
+
+    while (handler.count == 0)
+        if (!parser.parseNext())
+            return false;
+
+    return true;
+}
+
+// move to the next token, of kind End after all input
+inline const XMLToken& XMLReader::next() {
+
+    if (!fill())
+        return end;
+
+    // the slot is not reused until a later parse step
+    const XMLToken& current = handler.queue[handler.head];
+    handler.head = (handler.head + 1) % TokenHandler::QUEUE_SIZE;
+    --handler.count;
+
+    return current;
+}
+
+// token after the current one, without moving to it
+inline const XMLToken& XMLReader::peek() {
+
+    if (!fill())
+        return end;
+
+    return handler.queue[handler.head];
+}
+
+#endif
@@ -0,0 +1,105 @@
+/*
+    inputFiles.cpp
+
+    Expand the names of inputs into files. A name is one of:
+    * a file
+    * a glob, e.g., "*.xml", quoted so the shell does not expand it
+    * a directory, for the files directly in it, in sorted order
+    * @list, a file with one name per line, or @- for standard input
+
+    Globs that match nothing are kept, so the error is the missing file.
+*/
+
+#include "inputFiles.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cstdlib>
+
+#if !defined(_MSC_VER)
+#include <glob.h>
+#endif
+
+namespace {
+
+    // files of the glob, or the pattern when none match
+    void expandGlob(const std::string& pattern, std::vector<std::string>& files) {
+
+#if !defined(_MSC_VER)
+        glob_t matches;
+        if (glob(pattern.c_str(), 0, nullptr, &matches) == 0) {
+            for (std::size_t i = 0; i < matches.gl_pathc; ++i)
+                files.push_back(matches.gl_pathv[i]);
+            globfree(&matches);
+            return;
+        }
+        globfree(&matches);
+#endif
+        files.push_back(pattern);
+    }
+
+    // regular files directly in the directory, in sorted order
+    void expandDirectory(const std::string& directory, std::vector<std::string>& files) {
+
+        std::vector<std::string> entries;
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+            if (entry.is_regular_file(error))
+                entries.push_back(entry.path().string());
+        std::sort(entries.begin(), entries.end());
+        files.insert(files.end(), entries.begin(), entries.end());
+    }
+
+    // names in the list, one per line
+    void expandList(std::istream& list, std::vector<std::string>& names) {
+
+        std::string line;
+        while (std::getline(list, line)) {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (!line.empty())
+                names.push_back(line);
+        }
+    }
+}
+
+// input files of the names, expanding globs, directories, and @lists of files
+std::vector<std::string> expandInputs(const std::vector<std::string>& names) {
+
+    std::vector<std::string> files;
+    for (const std::string& name : names) {
+
+        if (name.size() > 1 && name[0] == '@') {
+
+            // names from a list are files, not patterns
+            std::vector<std::string> listed;
+            if (name == "@-") {
+                expandList(std::cin, listed);
+            } else {
+                std::ifstream list(name.substr(1));
+                if (!list) {
+                    std::cerr << "Unable to open file list " << name.substr(1) << '\n';
+                    exit(1);
+                }
+                expandList(list, listed);
+            }
+            files.insert(files.end(), listed.begin(), listed.end());
+
+        } else if (name.find_first_of("*?[") != std::string::npos) {
+
+            expandGlob(name, files);
+
+        } else {
+
+            std::error_code error;
+            if (std::filesystem::is_directory(name, error))
+                expandDirectory(name, files);
+            else
+                files.push_back(name);
+        }
+    }
+
+    return files;
+}
@@ -0,0 +1,16 @@
+/*
+    inputFiles.hpp
+
+    Input files named on the command line, for batch runs
+*/
+
+#ifndef INCLUDED_INPUTFILES_HPP
+#define INCLUDED_INPUTFILES_HPP
+
+#include <string>
+#include <vector>
+
+// input files of the names, expanding globs, directories, and @lists of files
+std::vector<std::string> expandInputs(const std::vector<std::string>& names);
+
+#endif
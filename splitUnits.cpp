@@ -0,0 +1,80 @@
+/*
+    splitUnits.cpp
+
+    Find the top-level units of a srcML archive, i.e., the
+    <unit> elements that are direct children of the root <unit>.
+    This is a depth-counting scan over '<' that only looks at
+    enough of each tag to track the element depth, so it is much
+    faster than a parse. The archive can then be parsed one unit
+    at a time.
+
+    @param data Start of the srcML
+    @param len Length of the srcML
+    @return Offset of the start tag of each top-level unit, in order
+*/
+
+#include "splitUnits.hpp"
+#include "xmlScan.hpp"
+
+#include <cstring>
+
+// offsets of the start tags of the units nested directly in the root unit
+std::vector<std::size_t> splitUnits(const char* data, std::size_t len) {
+
+    int depth = 0;
+    return splitUnits(data, len, depth);
+}
+
+// offsets of the start tags of the units at depth 1, starting at the depth, which is updated
+std::vector<std::size_t> splitUnits(const char* data, std::size_t len, int& depth) {
+
+    std::vector<std::size_t> offsets;
+    const char* const end = data + len;
+    const char* pc = data;
+    while ((pc = scanChar(pc, end, '<')) != end) {
+
+        if (end - pc >= 4 && std::memcmp(pc, "<!--", 4) == 0) {
+
+            // comment
+            pc = scanSequence(pc + 4, end, "-->");
+            pc = end - pc >= 3 ? pc + 3 : end;
+
+        } else if (end - pc >= 9 && std::memcmp(pc, "<![CDATA[", 9) == 0) {
+
+            // CDATA
+            pc = scanSequence(pc + 9, end, "]]>");
+            pc = end - pc >= 3 ? pc + 3 : end;
+
+        } else if (end - pc >= 2 && (pc[1] == '?' || pc[1] == '!')) {
+
+            // XML declaration, processing instruction, or DTD
+            pc = scanChar(pc, end, '>');
+
+        } else if (end - pc >= 2 && pc[1] == '/') {
+
+            // end tag
+            --depth;
+            pc = scanChar(pc, end, '>');
+
+        } else {
+
+            // start tag, with the local name "unit" for a unit
+            const char* endpc = scanChar(pc, end, '>');
+            const char* pnameend = pc + 1;
+            while (pnameend != endpc && *pnameend != '/' && *pnameend != ' ' && *pnameend != '\t'
+                   && *pnameend != '\n' && *pnameend != '\r')
+                ++pnameend;
+            const char* colon = static_cast<const char*>(std::memchr(pc + 1, ':', pnameend - (pc + 1)));
+            const char* plocalname = colon != nullptr ? colon + 1 : pc + 1;
+            if (depth == 1 && pnameend - plocalname == 4 && std::memcmp(plocalname, "unit", 4) == 0)
+                offsets.push_back((std::size_t) (pc - data));
+
+            // empty elements do not change the depth
+            if (endpc == end || endpc[-1] != '/')
+                ++depth;
+            pc = endpc;
+        }
+    }
+
+    return offsets;
+}
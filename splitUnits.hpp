@@ -0,0 +1,17 @@
+/*
+    splitUnits.hpp
+*/
+
+#ifndef INCLUDED_SPLITUNITS_HPP
+#define INCLUDED_SPLITUNITS_HPP
+
+#include <cstddef>
+#include <vector>
+
+// offsets of the start tags of the units nested directly in the root unit
+std::vector<std::size_t> splitUnits(const char* data, std::size_t len);
+
+// offsets of the start tags of the units at depth 1, starting at the depth, which is updated
+std::vector<std::size_t> splitUnits(const char* data, std::size_t len, int& depth);
+
+#endif
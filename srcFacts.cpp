@@ -1,126 +1,299 @@
 /*
     srcFacts.cpp
 
-    Produces a report with various counts of the number of 
+    Produces a report with various counts of the number of
     statements, declarations, etc. of a source code project
     in C++, C, Java, and C#.
 
     Input is an XML file in the srcML format.
 
+    Usage: srcFacts [-j jobs] [--check] [--stats] [file]
+           srcFacts [-j jobs] [--per-file] [--check] [--stats] name...
+           srcFacts [-j jobs] [--check] --index file
+           srcFacts --unit N file
+           srcFacts --filename name file
+
+    With more than one job, the top-level units of the archive are
+    parsed in parallel, and the counts are merged in document order.
+    The report is the same as with a single job.
+
+    With --index, the archive is indexed into the sidecar file.idx,
+    with the offset, length, and counts of each top-level unit. The
+    report of the Nth unit, from 1, or of the unit with the filename,
+    is then from the index, without parsing the archive.
+
+    Names are files, quoted globs, directories, or @lists of files. With
+    more than one file, the files are parsed concurrently on jobs
+    workers, by default one per core, each worker reusing one parser.
+    The report is of all files together, or with --per-file, a row for
+    each file.
+
+    With --check, the input is also checked for well-formedness: end
+    tags match start tags, no duplicate attributes, and valid names.
+
+    With --stats, the report is followed by the parse steps by kind,
+    with their counts, time, and bytes. This requires a build with
+    XML_PARSER_STATS.
+
     Code includes an almost-complete XML parser. Limitations:
     * DTD declarations are not handled
-    * Well-formedness is not checked
+    * Well-formedness is only checked with --check
 */
 
-#include "XMLParser.hpp"
+#include "BasicXMLParser.hpp"
+#include "srcFactsHandler.hpp"
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp"
+#include "srcFactsArchive.hpp"
+#include "srcMLIndex.hpp"
+#include "inputFiles.hpp"
 #include <iostream>
-#include <algorithm>
-
-int main() {
-
-    std::string url;
-    int textsize = 0;
-    int loc = 0;
-    int expr_count = 0;
-    int function_count = 0;
-    int class_count = 0;
-    int file_count = 0;
-    int decl_count = 0;
-    int comment_count = 0;
-    int return_count = 0;
-    int string_count = 0;
-    int line_comment_count = 0;
-    long total = 0;
-    std::string local_name;
-    std::string value;
-    std::string characters;
-
-     XMLParser parser(
-
-        // handleDeclaration(), unneeded
-        nullptr,
-
-        // count srcML items from Start Tag
-        [&expr_count, &function_count, &decl_count, &class_count,
-         &file_count, &comment_count, &return_count](const std::string& local_name, const std::string& prefix) {
-
-            if (local_name == "expr")
-                ++expr_count;
-            else if (local_name == "function")
-                ++function_count;
-            else if (local_name == "decl")
-                ++decl_count;
-            else if (local_name == "class")
-                ++class_count;
-            else if (local_name == "unit")
-                ++file_count;
-            else if (local_name == "comment")
-                ++comment_count;
-            else if (local_name == "return")
-                ++return_count;
-        },
-
-        // XML End Tag, unneeded
-        nullptr,
-
-        // update srcML url and count items from attributte
-        [&url, &string_count, &line_comment_count]
-        (const std::string& local_name, const std::string& value) {
-
-            if (local_name == "url")
-                url = value;
-            if (value == "string")
-                ++string_count;
-            if (value == "line")
-                ++line_comment_count;
-        },
-
-        // handleNamespace(), unneeded
-        nullptr,
-
-        // update textsize and loc from CDATA
-        [&textsize, &loc](const std::string& characters, const long& total) {
-
-            textsize += (int) characters.size();
-            loc += (int) std::count(characters.begin(), characters.end(), '\n');
-        },
-
-        // update textsize from entity
-        [&textsize](const std::string& characters, const long& total) {
-
-            textsize += (int) characters.size();
-        },
-
-        // update srcML items from characters
-        [&textsize, &loc](const std::string& characters, const char& c) {
-
-            loc += (int) std::count(characters.cbegin(), characters.cend(), '\n');
-            textsize += (int) characters.size();
-        },
-
-        // XML comment count, unnneeded
-        nullptr
-    );
-
-    // parse XML
-    parser.parse(total, characters, value, local_name);
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
 
-    // srcML report
-    std::cout << "# srcFacts: " << url << '\n';
+#if !defined(_MSC_VER)
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
+
+// srcML report
+static void report(std::string_view title, long total, const srcFactsCounts& counts) {
+
+    std::cout << "# srcFacts: " << title << '\n';
     std::cout << "| Item | Count |\n";
     std::cout << "|:-----|-----:|\n";
     std::cout << "| srcML | " << total << " |\n";
-    std::cout << "| files | " << file_count << " |\n";
-    std::cout << "| LOC | " << loc << " |\n";
-    std::cout << "| characters | " << textsize << " |\n";
-    std::cout << "| classes | " << class_count << " |\n";
-    std::cout << "| functions | " << function_count << " |\n";
-    std::cout << "| declarations | " << decl_count << " |\n";
-    std::cout << "| expressions | " << expr_count << " |\n";
-    std::cout << "| comments | " << comment_count << " |\n";
-    std::cout << "| returns | " << return_count << " |\n";
-    std::cout << "| string literals | " << string_count << " |\n";
-    std::cout << "| line comments | " << line_comment_count << " |\n";
+    std::cout << "| files | " << counts.file_count << " |\n";
+    std::cout << "| LOC | " << counts.loc << " |\n";
+    std::cout << "| characters | " << counts.textsize << " |\n";
+    std::cout << "| classes | " << counts.class_count << " |\n";
+    std::cout << "| functions | " << counts.function_count << " |\n";
+    std::cout << "| declarations | " << counts.decl_count << " |\n";
+    std::cout << "| expressions | " << counts.expr_count << " |\n";
+    std::cout << "| comments | " << counts.comment_count << " |\n";
+    std::cout << "| returns | " << counts.return_count << " |\n";
+    std::cout << "| string literals | " << counts.string_count << " |\n";
+    std::cout << "| line comments | " << counts.line_comment_count << " |\n";
+}
+
+// srcML report with a row for each file
+static void reportFiles(const std::vector<std::string>& files, const std::vector<long>& totals, const std::vector<srcFactsCounts>& results) {
+
+    std::cout << "| File | srcML | files | LOC | characters | classes | functions | declarations | expressions | comments | returns | string literals | line comments |\n";
+    std::cout << "|:-----|-----:|-----:|-----:|-----:|-----:|-----:|-----:|-----:|-----:|-----:|-----:|-----:|\n";
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        const srcFactsCounts& counts = results[i];
+        std::cout << "| " << files[i] << " | " << totals[i] << " | " << counts.file_count << " | " << counts.loc
+                  << " | " << counts.textsize << " | " << counts.class_count << " | " << counts.function_count
+                  << " | " << counts.decl_count << " | " << counts.expr_count << " | " << counts.comment_count
+                  << " | " << counts.return_count << " | " << counts.string_count << " | " << counts.line_comment_count << " |\n";
+    }
+}
+
+// count each file concurrently, with one parser for each worker
+// @return false if a file could not be opened
+static bool batchFacts(const std::vector<std::string>& files, int jobs, bool check, std::vector<long>& totals, std::vector<srcFactsCounts>& results, XMLParserStats& stats) {
+
+    ThreadPool pool(jobs);
+    struct Worker {
+        srcFactsHandler facts;
+        BasicXMLParser<srcFactsHandler> parser{facts};
+    };
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < pool.size(); ++i) {
+        workers.push_back(std::make_unique<Worker>());
+        workers.back()->parser.checkWellFormed(check);
+    }
+
+    totals.assign(files.size(), 0);
+    results.assign(files.size(), srcFactsCounts());
+    std::vector<char> failed(files.size(), false);
+    pool.run(files.size(), [&](std::size_t index, int worker) {
+
+        const int fd = open(files[index].c_str(), O_RDONLY);
+        if (fd == -1) {
+            failed[index] = true;
+            return;
+        }
+        Worker& current = *workers[worker];
+        current.facts.counts = srcFactsCounts();
+        current.parser.parse(fd, totals[index]);
+        close(fd);
+        results[index] = std::move(current.facts.counts);
+    });
+
+    for (const auto& current : workers)
+        stats += current->parser.stats();
+
+    bool ok = true;
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        if (failed[i]) {
+            std::cerr << "srcFacts: Unable to open file " << files[i] << '\n';
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+
+    // options
+    int jobs = -1;
+    std::vector<std::string> names;
+    bool perFile = false;
+    bool showStats = false;
+    bool check = false;
+    bool index = false;
+    long unitNumber = 0;
+    const char* unitFilename = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            jobs = std::atoi(argv[++i]);
+        } else if (std::strncmp(argv[i], "--jobs=", strlen("--jobs=")) == 0) {
+            jobs = std::atoi(argv[i] + strlen("--jobs="));
+        } else if (std::strcmp(argv[i], "--index") == 0) {
+            index = true;
+        } else if (std::strcmp(argv[i], "--unit") == 0 && i + 1 < argc) {
+            unitNumber = std::atol(argv[++i]);
+        } else if (std::strcmp(argv[i], "--filename") == 0 && i + 1 < argc) {
+            unitFilename = argv[++i];
+        } else if (std::strcmp(argv[i], "--per-file") == 0) {
+            perFile = true;
+        } else if (std::strcmp(argv[i], "--stats") == 0) {
+            showStats = true;
+        } else if (std::strcmp(argv[i], "--check") == 0) {
+            check = true;
+        } else {
+            names.push_back(argv[i]);
+        }
+    }
+    const bool query = unitNumber != 0 || unitFilename != nullptr;
+
+    if (showStats && !XMLParserStats::enabled) {
+        std::cerr << "srcFacts: --stats requires a build with XML_PARSER_STATS\n";
+        return 1;
+    }
+    XMLParserStats stats;
+
+    // batch of files, by default with one job per core
+    const std::vector<std::string> files = expandInputs(names);
+    if (files.size() > 1 || perFile) {
+        if (index || query) {
+            std::cerr << "srcFacts: Index is of a single archive file\n";
+            return 1;
+        }
+        std::vector<long> totals;
+        std::vector<srcFactsCounts> results;
+        if (!batchFacts(files, jobs == -1 ? 0 : jobs, check, totals, results, stats))
+            return 1;
+        if (perFile) {
+            reportFiles(files, totals, results);
+        } else {
+            long total = 0;
+            srcFactsCounts counts;
+            for (std::size_t i = 0; i < files.size(); ++i) {
+                total += totals[i];
+                counts += results[i];
+            }
+            report(std::to_string(files.size()) + " files", total, counts);
+        }
+        if (showStats)
+            stats.report(std::cout);
+
+        return 0;
+    }
+    if (jobs == -1)
+        jobs = 1;
+    const char* filename = files.empty() ? nullptr : files[0].c_str();
+
+    // input is the named file, or standard input
+    int fd = 0;
+    if (filename != nullptr) {
+        fd = open(filename, O_RDONLY);
+        if (fd == -1) {
+            std::cerr << "srcFacts: Unable to open file " << filename << '\n';
+            return 1;
+        }
+    }
+
+    // the index is a sidecar of a named archive
+    if ((index || query) && filename == nullptr) {
+        std::cerr << "srcFacts: Index requires an archive file\n";
+        return 1;
+    }
+
+    // report of a unit from the index
+    if (query) {
+        MappedFile file(fd);
+        std::string contents;
+        if (!file.isMapped())
+            contents = readAll(fd);
+        const char* data = file.isMapped() ? file.data() : contents.data();
+        const std::size_t len = file.isMapped() ? file.size() : contents.size();
+        const srcMLIndex units(srcMLIndex::sidecarPath(filename), data, len);
+        if (!units.isValid()) {
+            std::cerr << "srcFacts: Index of " << filename << " is missing or stale, rebuild with --index\n";
+            return 1;
+        }
+        const long unit = unitFilename != nullptr ? units.find(unitFilename) : unitNumber - 1;
+        if (unit < 0 || (std::size_t) unit >= units.size()) {
+            std::cerr << "srcFacts: No such unit in " << filename << '\n';
+            return 1;
+        }
+        report(units.filename(unit), (long) units.length(unit), units.counts(unit));
+
+        return 0;
+    }
+
+    long total = 0;
+    srcFactsCounts counts;
+    if (index) {
+
+        // index the whole input in memory
+        MappedFile file(fd);
+        std::string contents;
+        if (!file.isMapped())
+            contents = readAll(fd);
+        const char* data = file.isMapped() ? file.data() : contents.data();
+        const std::size_t len = file.isMapped() ? file.size() : contents.size();
+        counts = srcMLIndex::build(srcMLIndex::sidecarPath(filename), data, len, jobs, check);
+        total = (long) len;
+
+    } else if (jobs == 1) {
+
+        // parse XML
+        srcFactsHandler facts;
+        BasicXMLParser<srcFactsHandler> parser(facts);
+        parser.checkWellFormed(check);
+        parser.parse(fd, total);
+        counts = std::move(facts.counts);
+        stats = parser.stats();
+
+    } else {
+
+        // parallel parse of the whole input in memory
+        MappedFile file(fd);
+        std::string contents;
+        if (!file.isMapped())
+            contents = readAll(fd);
+        const char* data = file.isMapped() ? file.data() : contents.data();
+        const std::size_t len = file.isMapped() ? file.size() : contents.size();
+        const srcFactsArchive archive(data, len, jobs, check);
+        counts = archive.totals();
+        stats = archive.stats();
+        total = (long) len;
+    }
+
+    // srcML report
+    report(counts.url, total, counts);
+    if (showStats)
+        stats.report(std::cout);
 
     return 0;
 }
@@ -0,0 +1,228 @@
+/*
+    srcFactsArchive.cpp
+
+    Implementation file for the srcFacts counts of an archive by unit
+*/
+
+#include "srcFactsArchive.hpp"
+#include "ThreadPool.hpp"
+#include "splitUnits.hpp"
+
+#include <algorithm>
+#include <memory>
+
+// count the archive, with the top-level units parsed on jobs threads, and checked for well-formedness when check is true
+srcFactsArchive::srcFactsArchive(const char* data, std::size_t len, int jobs, bool check) {
+
+    parser.checkWellFormed(check);
+
+    // segments start at each top-level unit, with the root start tag before the first
+    std::vector<std::size_t> bounds = splitUnits(data, len);
+    bounds.insert(bounds.begin(), 0);
+    bounds.push_back(len);
+    segments.resize(bounds.size() - 1);
+    for (std::size_t i = 0; i < segments.size(); ++i) {
+        segments[i].offset = bounds[i];
+        segments[i].length = bounds[i + 1] - bounds[i];
+    }
+
+    if (jobs == 1) {
+
+        count(data, segments.begin(), segments.end(), true, segments.size() == 1);
+
+    } else {
+
+        // each worker has its own parser and counts
+        ThreadPool pool(jobs);
+        struct Worker {
+            srcFactsHandler facts;
+            BasicXMLParser<srcFactsHandler> parser{facts};
+        };
+        std::vector<std::unique_ptr<Worker>> workers;
+            for (int i = 0; i < pool.size(); ++i) {
+            workers.push_back(std::make_unique<Worker>());
+            workers.back()->parser.checkWellFormed(check);
+        }
+
+        pool.run(segments.size(), [&](std::size_t index, int worker) {
+
+            Worker& current = *workers[worker];
+            Segment& segment = segments[index];
+            current.facts.counts = srcFactsCounts();
+            if (index == 0)
+                parseStart(current.parser, data + segment.offset, segment.length, segments.size() == 1);
+            else
+                current.parser.parseFragment(data + segment.offset, segment.length, 1, segment.offset);
+            segment.counts = std::move(current.facts.counts);
+        });
+
+        for (const auto& current : workers)
+            parseStats += current->parser.stats();
+    }
+    parsed = len;
+
+    // merge in document order
+    for (const Segment& segment : segments)
+        total += segment.counts;
+}
+
+// parse the start of the archive, which leaves the root element open unless it is the whole archive
+void srcFactsArchive::parseStart(BasicXMLParser<srcFactsHandler>& parser, const char* data, std::size_t length, bool wholeDocument) const {
+
+    if (wholeDocument)
+        parser.parse(data, length);
+    else
+        parser.parseFragment(data, length, 0);
+}
+
+// count the segments with the parser, the first at the start of the archive when first is true,
+// and the whole archive when wholeDocument is true
+void srcFactsArchive::count(const char* data, std::vector<Segment>::iterator begin, std::vector<Segment>::iterator end, bool first, bool wholeDocument) {
+
+    const XMLParserStats before = parser.stats();
+    for (auto segment = begin; segment != end; ++segment) {
+        facts.counts = srcFactsCounts();
+        if (first && segment == begin)
+            parseStart(parser, data + segment->offset, segment->length, wholeDocument);
+        else
+            parser.parseFragment(data + segment->offset, segment->length, 1, segment->offset);
+        segment->counts = std::move(facts.counts);
+    }
+
+    // only the stats of this parse, since the parser keeps them all
+    XMLParserStats added = parser.stats();
+    for (int kind = 0; kind < XMLParserStats::KINDS; ++kind) {
+        added.count[kind] -= before.count[kind];
+        added.ticks[kind] -= before.ticks[kind];
+        added.bytes[kind] -= before.bytes[kind];
+    }
+    added.refills -= before.refills;
+    added.tailBytes -= before.tailBytes;
+    added.partialTokens -= before.partialTokens;
+    parseStats += added;
+}
+
+// segment containing the byte offset
+std::size_t srcFactsArchive::segmentAt(std::size_t offset) const {
+
+    const auto after = std::upper_bound(segments.begin(), segments.end(), offset,
+        [](std::size_t value, const Segment& segment) { return value < segment.offset; });
+
+    return (std::size_t) std::distance(segments.begin(), after) - 1;
+}
+
+// update for the edit that replaced oldLength bytes at offset with newLength bytes,
+// giving the archive now in data
+// @return false, with the counts unchanged, if the edit does not match the archive
+bool srcFactsArchive::update(const char* data, std::size_t len, std::size_t offset, std::size_t oldLength, std::size_t newLength) {
+
+    const std::size_t oldSize = segments.back().offset + segments.back().length;
+    if (offset > oldSize || oldLength > oldSize - offset || len + oldLength != oldSize + newLength)
+        return false;
+    const long delta = (long) newLength - (long) oldLength;
+
+    // segments that overlap the edit, including the one it ends in
+    std::size_t first = segmentAt(offset);
+    std::size_t last = segmentAt(oldLength != 0 ? offset + oldLength - 1 : offset);
+
+    // widen until the edited region starts at a unit and ends before the next unit
+    std::vector<std::size_t> bounds;
+    std::size_t start = 0;
+    std::size_t end = 0;
+    while (true) {
+        start = segments[first].offset;
+        end = (std::size_t) ((long) (segments[last].offset + segments[last].length) + delta);
+        int depth = first == 0 ? 0 : 1;
+        bounds = splitUnits(data + start, end - start, depth);
+        if (first > 0 && (bounds.empty() || bounds.front() != 0)) {
+            --first;
+            continue;
+        }
+        if (last + 1 < segments.size() && depth != 1) {
+            ++last;
+            continue;
+        }
+        break;
+    }
+
+    // new segments of the region
+    if (first == 0)
+        bounds.insert(bounds.begin(), 0);
+    bounds.push_back(end - start);
+    std::vector<Segment> replacements(bounds.size() - 1);
+    for (std::size_t i = 0; i < replacements.size(); ++i) {
+        replacements[i].offset = start + bounds[i];
+        replacements[i].length = bounds[i + 1] - bounds[i];
+    }
+    // the start of the archive is the whole archive when it replaces every segment and has no units
+    const bool wholeDocument = first == 0 && last + 1 == segments.size() && replacements.size() == 1;
+    count(data, replacements.begin(), replacements.end(), first == 0, wholeDocument);
+    parsed = end - start;
+
+    // replace the counts of the old segments with the new
+    bool urlRemoved = false;
+    for (std::size_t i = first; i <= last; ++i) {
+        total -= segments[i].counts;
+        urlRemoved = urlRemoved || !segments[i].counts.url.empty();
+    }
+    for (const Segment& segment : replacements)
+        total += segment.counts;
+
+    // replace the segments, and move the ones after
+    const auto after = segments.erase(segments.begin() + first, segments.begin() + last + 1);
+    const auto moved = segments.insert(after, replacements.begin(), replacements.end()) + replacements.size();
+    for (auto segment = moved; segment != segments.end(); ++segment)
+        segment->offset = (std::size_t) ((long) segment->offset + delta);
+
+    // the url is from the last segment that has one
+    if (urlRemoved) {
+        total.url.clear();
+        for (const Segment& segment : segments)
+            if (!segment.counts.url.empty())
+                total.url = segment.counts.url;
+    }
+
+    return true;
+}
+
+// counts of the whole archive
+const srcFactsCounts& srcFactsArchive::totals() const {
+
+    return total;
+}
+
+// number of top-level units
+std::size_t srcFactsArchive::size() const {
+
+    return segments.size() - 1;
+}
+
+// byte offset of the start tag of the unit
+std::size_t srcFactsArchive::offset(std::size_t unit) const {
+
+    return segments[unit + 1].offset;
+}
+
+// byte length of the unit, up to the next unit or the end of the archive
+std::size_t srcFactsArchive::length(std::size_t unit) const {
+
+    return segments[unit + 1].length;
+}
+
+// counts of the unit
+const srcFactsCounts& srcFactsArchive::counts(std::size_t unit) const {
+
+    return segments[unit + 1].counts;
+}
+
+// parse step stats of all parses, when built with XML_PARSER_STATS
+const XMLParserStats& srcFactsArchive::stats() const {
+
+    return parseStats;
+}
+
+// bytes parsed by the last construction or update
+std::size_t srcFactsArchive::bytesParsed() const {
+
+    return parsed;
+}
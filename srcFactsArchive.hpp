@@ -0,0 +1,91 @@
+/*
+    srcFactsArchive.hpp
+
+    srcFacts counts of a srcML archive, retained for each top-level
+    unit so that an edit only reparses the units it touches.
+
+    The archive is split into segments: the start of the archive up to
+    the first unit, then each top-level unit up to the next. The counts
+    of each segment are kept, and the totals are their sum. After an
+    edit, the segments that overlap the changed bytes are split and
+    counted again, their old counts are subtracted from the totals and
+    the new counts added, and the later segments are only moved.
+
+    The archive itself is not kept, so each call is given the current
+    contents.
+*/
+
+#ifndef INCLUDED_SRCFACTSARCHIVE_HPP
+#define INCLUDED_SRCFACTSARCHIVE_HPP
+
+#include "BasicXMLParser.hpp"
+#include "srcFactsHandler.hpp"
+#include "XMLParserStats.hpp"
+
+#include <vector>
+#include <cstddef>
+
+class srcFactsArchive {
+public:
+
+    // count the archive, with the top-level units parsed on jobs threads, and checked for well-formedness when check is true
+    srcFactsArchive(const char* data, std::size_t len, int jobs = 1, bool check = false);
+
+    srcFactsArchive(const srcFactsArchive&) = delete;
+    srcFactsArchive& operator=(const srcFactsArchive&) = delete;
+
+    // update for the edit that replaced oldLength bytes at offset with newLength bytes,
+    // giving the archive now in data
+    // @return false, with the counts unchanged, if the edit does not match the archive
+    bool update(const char* data, std::size_t len, std::size_t offset, std::size_t oldLength, std::size_t newLength);
+
+    // counts of the whole archive
+    const srcFactsCounts& totals() const;
+
+    // number of top-level units
+    std::size_t size() const;
+
+    // byte offset of the start tag of the unit
+    std::size_t offset(std::size_t unit) const;
+
+    // byte length of the unit, up to the next unit or the end of the archive
+    std::size_t length(std::size_t unit) const;
+
+    // counts of the unit
+    const srcFactsCounts& counts(std::size_t unit) const;
+
+    // parse step stats of all parses, when built with XML_PARSER_STATS
+    const XMLParserStats& stats() const;
+
+    // bytes parsed by the last construction or update
+    std::size_t bytesParsed() const;
+
+private:
+
+    // part of the archive, the start of the archive or a unit, with its counts
+    struct Segment {
+        std::size_t offset = 0;
+        std::size_t length = 0;
+        srcFactsCounts counts;
+    };
+
+    // parse the start of the archive, which leaves the root element open unless it is the whole archive
+    void parseStart(BasicXMLParser<srcFactsHandler>& parser, const char* data, std::size_t length, bool wholeDocument) const;
+
+    // count the segments with the parser, the first at the start of the archive when first is true,
+    // and the whole archive when wholeDocument is true
+    void count(const char* data, std::vector<Segment>::iterator begin, std::vector<Segment>::iterator end, bool first, bool wholeDocument);
+
+    // segment containing the byte offset
+    std::size_t segmentAt(std::size_t offset) const;
+
+    std::vector<Segment> segments;
+    srcFactsCounts total;
+    XMLParserStats parseStats;
+    std::size_t parsed = 0;
+
+    srcFactsHandler facts;
+    BasicXMLParser<srcFactsHandler> parser{facts};
+};
+
+#endif
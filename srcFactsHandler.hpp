@@ -0,0 +1,183 @@
+/*
+    srcFactsHandler.hpp
+
+    BasicXMLParser handler that counts srcML items, e.g., files,
+    functions, declarations, and lines of code.
+
+    Element and attribute names are classified once per name ID, so
+    each event after the first of a name is an array lookup. The lines
+    of code are the newlines counted by the parser in its scan of the
+    characters.
+*/
+
+#ifndef INCLUDED_SRCFACTSHANDLER_HPP
+#define INCLUDED_SRCFACTSHANDLER_HPP
+
+#include "xmlEntities.hpp"
+#include "XMLAttributes.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// srcML counts
+struct srcFactsCounts {
+
+    // add the counts of input that follows
+    srcFactsCounts& operator+=(const srcFactsCounts& other) {
+
+        if (!other.url.empty())
+            url = other.url;
+        textsize += other.textsize;
+        loc += other.loc;
+        expr_count += other.expr_count;
+        function_count += other.function_count;
+        class_count += other.class_count;
+        file_count += other.file_count;
+        decl_count += other.decl_count;
+        comment_count += other.comment_count;
+        return_count += other.return_count;
+        string_count += other.string_count;
+        line_comment_count += other.line_comment_count;
+
+        return *this;
+    }
+
+    // remove the counts of input, e.g., of a unit before it is replaced
+    // The url is kept.
+    srcFactsCounts& operator-=(const srcFactsCounts& other) {
+
+        textsize -= other.textsize;
+        loc -= other.loc;
+        expr_count -= other.expr_count;
+        function_count -= other.function_count;
+        class_count -= other.class_count;
+        file_count -= other.file_count;
+        decl_count -= other.decl_count;
+        comment_count -= other.comment_count;
+        return_count -= other.return_count;
+        string_count -= other.string_count;
+        line_comment_count -= other.line_comment_count;
+
+        return *this;
+    }
+
+    std::string url;
+    long textsize = 0;
+    long loc = 0;
+    long expr_count = 0;
+    long function_count = 0;
+    long class_count = 0;
+    long file_count = 0;
+    long decl_count = 0;
+    long comment_count = 0;
+    long return_count = 0;
+    long string_count = 0;
+    long line_comment_count = 0;
+};
+
+// srcML counts from XML events
+class srcFactsHandler {
+public:
+
+    // count srcML items from Start Tag and its attributes
+    void handleStartTag(int id, std::string_view local_name, std::string_view prefix, const XMLAttributes& attributes) {
+
+        if ((std::size_t) id >= elementKinds.size())
+            elementKinds.resize(id + 1, UNCLASSIFIED);
+        if (elementKinds[id] == UNCLASSIFIED)
+            elementKinds[id] = elementKind(local_name);
+
+        const auto counter = ELEMENT_COUNTERS[elementKinds[id]];
+        if (counter != nullptr)
+            ++(counts.*counter);
+
+        for (const XMLAttribute& attribute : attributes)
+            if (!attribute.isNamespace)
+                countAttribute(attribute.id, attribute.local_name, attribute.value);
+    }
+
+    // update textsize and loc from CDATA
+    void handleCDATA(std::string_view characters, long newlines) {
+
+        counts.textsize += (long) characters.size();
+        counts.loc += newlines;
+    }
+
+    // update textsize from entity
+    void handleEntity(std::string_view characters) {
+
+        counts.textsize += (long) characters.size();
+    }
+
+    // update srcML items from characters
+    void handleCharacters(std::string_view characters, long newlines) {
+
+        counts.loc += newlines;
+        counts.textsize += (long) characters.size();
+    }
+
+    srcFactsCounts counts;
+
+private:
+
+    // update srcML url and count items from attributte
+    void countAttribute(int id, std::string_view local_name, std::string_view value) {
+
+        if ((std::size_t) id >= urlAttributes.size())
+            urlAttributes.resize(id + 1, UNCLASSIFIED);
+        if (urlAttributes[id] == UNCLASSIFIED)
+            urlAttributes[id] = local_name == "url";
+
+        if (urlAttributes[id]) {
+            std::string decoded;
+            counts.url = decodeXMLText(value, decoded);
+        }
+        if (value == "string")
+            ++counts.string_count;
+        if (value == "line")
+            ++counts.line_comment_count;
+    }
+
+    // index into ELEMENT_COUNTERS of the element name
+    static signed char elementKind(std::string_view local_name) {
+
+        if (local_name == "expr")
+            return 1;
+        else if (local_name == "function")
+            return 2;
+        else if (local_name == "decl")
+            return 3;
+        else if (local_name == "class")
+            return 4;
+        else if (local_name == "unit")
+            return 5;
+        else if (local_name == "comment")
+            return 6;
+        else if (local_name == "return")
+            return 7;
+        return 0;
+    }
+
+    static constexpr signed char UNCLASSIFIED = -1;
+
+    // counter of each element kind, none for uncounted elements
+    static constexpr long srcFactsCounts::* ELEMENT_COUNTERS[] = {
+        nullptr,
+        &srcFactsCounts::expr_count,
+        &srcFactsCounts::function_count,
+        &srcFactsCounts::decl_count,
+        &srcFactsCounts::class_count,
+        &srcFactsCounts::file_count,
+        &srcFactsCounts::comment_count,
+        &srcFactsCounts::return_count,
+    };
+
+    // element kind by name ID
+    std::vector<signed char> elementKinds;
+
+    // is the attribute a url, by name ID
+    std::vector<signed char> urlAttributes;
+};
+
+#endif
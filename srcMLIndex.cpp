@@ -0,0 +1,372 @@
+/*
+    srcMLIndex.cpp
+
+    Implementation file for the sidecar index of srcML archives
+*/
+
+#include "srcMLIndex.hpp"
+#include "BasicXMLParser.hpp"
+#include "ThreadPool.hpp"
+#include "splitUnits.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+
+#if !defined(_MSC_VER)
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
+
+namespace {
+
+    // identifies the file, and its layout
+    const char MAGIC[8] = { 's', 'r', 'c', 'M', 'L', 'I', 'D', 'X' };
+    const std::uint32_t VERSION = 1;
+
+    // blocks of the archive hashed for validation
+    const std::size_t SAMPLE_BLOCKS = 16;
+    const std::size_t SAMPLE_BLOCK_SIZE = 4096;
+
+    // counters of srcFactsCounts, in index order
+    constexpr long srcFactsCounts::* COUNTERS[SRCML_INDEX_COUNTS] = {
+        &srcFactsCounts::textsize,
+        &srcFactsCounts::loc,
+        &srcFactsCounts::expr_count,
+        &srcFactsCounts::function_count,
+        &srcFactsCounts::class_count,
+        &srcFactsCounts::file_count,
+        &srcFactsCounts::decl_count,
+        &srcFactsCounts::comment_count,
+        &srcFactsCounts::return_count,
+        &srcFactsCounts::string_count,
+        &srcFactsCounts::line_comment_count,
+    };
+
+    // store the counters
+    void storeCounts(const srcFactsCounts& counts, std::int64_t stored[SRCML_INDEX_COUNTS]) {
+
+        for (int i = 0; i < SRCML_INDEX_COUNTS; ++i)
+            stored[i] = counts.*COUNTERS[i];
+    }
+
+    // load the counters
+    srcFactsCounts loadCounts(const std::int64_t stored[SRCML_INDEX_COUNTS]) {
+
+        srcFactsCounts counts;
+        for (int i = 0; i < SRCML_INDEX_COUNTS; ++i)
+            counts.*COUNTERS[i] = (long) stored[i];
+
+        return counts;
+    }
+
+    // hash of the size and of evenly spaced blocks, including the first and last
+    std::uint64_t sampleHash(const char* data, std::size_t len) {
+
+        // FNV-1a
+        std::uint64_t value = 14695981039346656037ull;
+        const auto add = [&value](const char* first, std::size_t size) {
+
+            for (std::size_t i = 0; i < size; ++i) {
+                value ^= (unsigned char) first[i];
+                value *= 1099511628211ull;
+            }
+        };
+        const std::uint64_t size = len;
+        add((const char*) &size, sizeof(size));
+        if (len <= SAMPLE_BLOCKS * SAMPLE_BLOCK_SIZE) {
+            add(data, len);
+            return value;
+        }
+        const std::size_t stride = (len - SAMPLE_BLOCK_SIZE) / (SAMPLE_BLOCKS - 1);
+        for (std::size_t block = 0; block < SAMPLE_BLOCKS; ++block)
+            add(data + block * stride, SAMPLE_BLOCK_SIZE);
+
+        return value;
+    }
+
+    // end of the unit element starting the segment, before whitespace and any root end tag
+    std::size_t unitEnd(const char* data, std::size_t start, std::size_t end, bool last) {
+
+        // the root end tag is the last tag of the last segment
+        if (last) {
+            while (end > start && data[end - 1] != '<')
+                --end;
+            if (end > start)
+                --end;
+        }
+        while (end > start && isXMLSpace(data[end - 1]))
+            --end;
+
+        return end;
+    }
+
+    // BasicXMLParser handler for the filename and language attributes of a start tag
+    struct UnitAttributes {
+
+        XMLControl handleStartTag() {
+
+            return ++tags > 1 ? XMLControl::Stop : XMLControl::Continue;
+        }
+
+        XMLControl handleEndTag() {
+
+            return XMLControl::Stop;
+        }
+
+        XMLControl handleCharacters() {
+
+            return XMLControl::Stop;
+        }
+
+        void handleAttribute(int /* id */, std::string_view local_name, std::string_view value) {
+
+            if (local_name == "filename")
+                filename = value;
+            else if (local_name == "language")
+                language = value;
+        }
+
+        int tags = 0;
+        std::string filename;
+        std::string language;
+    };
+
+    // unit as indexed, before the strings are placed
+    struct Unit {
+        std::size_t offset = 0;
+        std::size_t length = 0;
+        std::string filename;
+        std::string language;
+        srcFactsCounts counts;
+
+        // counts of the whitespace, and any root end tag, after the unit
+        srcFactsCounts after;
+    };
+}
+
+// path of the sidecar index of the archive
+std::string srcMLIndex::sidecarPath(const std::string& archive) {
+
+    return archive + ".idx";
+}
+
+// index the srcML archive in memory with jobs threads, and write the index to the path
+srcFactsCounts srcMLIndex::build(const std::string& path, const char* data, std::size_t len, int jobs, bool check) {
+
+    // units, and the root start tag before the first
+    const std::vector<std::size_t> offsets = splitUnits(data, len);
+    std::vector<Unit> units(offsets.size());
+    const std::size_t prologue = offsets.empty() ? len : offsets.front();
+
+    // each worker has its own parser and counts
+    ThreadPool pool(jobs);
+    struct Worker {
+        srcFactsHandler facts;
+        BasicXMLParser<srcFactsHandler> parser{facts};
+    };
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < pool.size(); ++i) {
+        workers.push_back(std::make_unique<Worker>());
+        workers.back()->parser.checkWellFormed(check);
+    }
+
+    // task 0 is the prologue, and task n is unit n - 1
+    srcFactsCounts rootCounts;
+    pool.run(units.size() + 1, [&](std::size_t index, int worker) {
+
+        Worker& current = *workers[worker];
+        current.facts.counts = srcFactsCounts();
+        // the root element is left open, unless there are no units
+        if (index == 0) {
+            if (offsets.empty())
+                current.parser.parse(data, prologue);
+            else
+                current.parser.parseFragment(data, prologue, 0);
+            rootCounts = std::move(current.facts.counts);
+            return;
+        }
+
+        Unit& unit = units[index - 1];
+        const std::size_t next = index < offsets.size() ? offsets[index] : len;
+        const std::size_t end = unitEnd(data, offsets[index - 1], next, index == offsets.size());
+        unit.offset = offsets[index - 1];
+        unit.length = end - unit.offset;
+
+        current.parser.parse(data + unit.offset, unit.length, unit.offset);
+        unit.counts = std::move(current.facts.counts);
+
+        current.facts.counts = srcFactsCounts();
+        current.parser.parseFragment(data + end, next - end, 1, end);
+        unit.after = std::move(current.facts.counts);
+
+        UnitAttributes attributes;
+        BasicXMLParser<UnitAttributes> parser(attributes);
+        parser.parse(data + unit.offset, unit.length, unit.offset);
+        unit.filename = std::move(attributes.filename);
+        unit.language = std::move(attributes.language);
+    });
+
+    // merge in document order
+    srcFactsCounts totals = rootCounts;
+    for (const Unit& unit : units) {
+        totals += unit.counts;
+        totals += unit.after;
+    }
+
+    // string table
+    std::string strings;
+    const auto place = [&strings](const std::string& s, std::uint32_t& stringOffset, std::uint32_t& stringLength) {
+
+        stringOffset = (std::uint32_t) strings.size();
+        stringLength = (std::uint32_t) s.size();
+        strings += s;
+    };
+
+    srcMLIndexHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.unitCount = (std::uint32_t) units.size();
+    header.sourceSize = len;
+    header.sourceHash = sampleHash(data, len);
+    header.stringsOffset = sizeof(srcMLIndexHeader) + units.size() * sizeof(srcMLIndexUnit);
+    storeCounts(totals, header.totals);
+    place(totals.url, header.urlOffset, header.urlLength);
+
+    std::vector<srcMLIndexUnit> entries(units.size());
+    for (std::size_t i = 0; i < units.size(); ++i) {
+        srcMLIndexUnit& entry = entries[i];
+        entry.offset = units[i].offset;
+        entry.length = units[i].length;
+        place(units[i].filename, entry.filenameOffset, entry.filenameLength);
+        place(units[i].language, entry.languageOffset, entry.languageLength);
+        storeCounts(units[i].counts, entry.counts);
+    }
+    header.stringsSize = strings.size();
+
+    // write to a temporary file, and replace any old index only when complete
+    const std::string temporary = path + ".tmp";
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    out.write((const char*) &header, sizeof(header));
+    out.write((const char*) entries.data(), (std::streamsize) (entries.size() * sizeof(srcMLIndexUnit)));
+    out.write(strings.data(), (std::streamsize) strings.size());
+    out.close();
+    if (!out || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        std::cerr << "srcMLIndex: Unable to write index " << path << '\n';
+        exit(1);
+    }
+
+    return totals;
+}
+
+// open the index at the path for the srcML archive in memory
+srcMLIndex::srcMLIndex(const std::string& path, const char* data, std::size_t len)
+    : archive(data)
+{
+
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+        return;
+    file.reset(new MappedFile(fd));
+    close(fd);
+    if (!file->isMapped() || file->size() < sizeof(srcMLIndexHeader))
+        return;
+
+    // layout
+    const srcMLIndexHeader* candidate = (const srcMLIndexHeader*) file->data();
+    if (std::memcmp(candidate->magic, MAGIC, sizeof(MAGIC)) != 0 || candidate->version != VERSION)
+        return;
+    if (candidate->stringsOffset != sizeof(srcMLIndexHeader) + candidate->unitCount * sizeof(srcMLIndexUnit)
+        || candidate->stringsOffset + candidate->stringsSize != file->size())
+        return;
+
+    // archive
+    if (candidate->sourceSize != len || candidate->sourceHash != sampleHash(data, len))
+        return;
+
+    header = candidate;
+    units = (const srcMLIndexUnit*) (file->data() + sizeof(srcMLIndexHeader));
+    strings = file->data() + header->stringsOffset;
+}
+
+// is the index present and for this archive
+bool srcMLIndex::isValid() const {
+
+    return header != nullptr;
+}
+
+// number of top-level units
+std::size_t srcMLIndex::size() const {
+
+    return header->unitCount;
+}
+
+// byte offset of the unit start tag in the archive
+std::uint64_t srcMLIndex::offset(std::size_t unit) const {
+
+    return units[unit].offset;
+}
+
+// byte length of the unit element
+std::uint64_t srcMLIndex::length(std::size_t unit) const {
+
+    return units[unit].length;
+}
+
+// unit element in the archive, ready to parse
+std::string_view srcMLIndex::source(std::size_t unit) const {
+
+    return std::string_view(archive + units[unit].offset, units[unit].length);
+}
+
+// string in the string table
+std::string_view srcMLIndex::string(std::uint32_t stringOffset, std::uint32_t stringLength) const {
+
+    if ((std::uint64_t) stringOffset + stringLength > header->stringsSize)
+        return std::string_view();
+
+    return std::string_view(strings + stringOffset, stringLength);
+}
+
+// filename attribute of the unit
+std::string_view srcMLIndex::filename(std::size_t unit) const {
+
+    return string(units[unit].filenameOffset, units[unit].filenameLength);
+}
+
+// language attribute of the unit
+std::string_view srcMLIndex::language(std::size_t unit) const {
+
+    return string(units[unit].languageOffset, units[unit].languageLength);
+}
+
+// srcFacts counts of the unit
+srcFactsCounts srcMLIndex::counts(std::size_t unit) const {
+
+    return loadCounts(units[unit].counts);
+}
+
+// srcFacts counts of the whole archive
+srcFactsCounts srcMLIndex::totals() const {
+
+    srcFactsCounts counts = loadCounts(header->totals);
+    counts.url = string(header->urlOffset, header->urlLength);
+
+    return counts;
+}
+
+// index of the first unit with the filename, or -1 if none
+long srcMLIndex::find(std::string_view name) const {
+
+    for (std::size_t unit = 0; unit < size(); ++unit)
+        if (filename(unit) == name)
+            return (long) unit;
+
+    return -1;
+}
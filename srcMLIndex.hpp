@@ -0,0 +1,122 @@
+/*
+    srcMLIndex.hpp
+
+    Sidecar index of the top-level units of a srcML archive. For each
+    unit it records the byte offset and length of the unit element,
+    the filename and language attributes, and the srcFacts counts of
+    the unit, with the counts of the whole archive in the header. A
+    unit, or the report of a unit or the whole archive, is then found
+    without parsing the archive.
+
+    The file is mapped and used in place:
+
+        header       srcMLIndexHeader
+        units        srcMLIndexUnit[unitCount]
+        strings      filenames, languages, and the url, not terminated
+
+    Integers are in the native byte order, so an index from a machine
+    with a different byte order fails validation by its version. The
+    index is valid for an archive of the same size and the same hash
+    of a sample of its blocks.
+*/
+
+#ifndef INCLUDED_SRCMLINDEX_HPP
+#define INCLUDED_SRCMLINDEX_HPP
+
+#include "srcFactsHandler.hpp"
+#include "MappedFile.hpp"
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+// number of counters of srcFactsCounts
+constexpr int SRCML_INDEX_COUNTS = 11;
+
+// header of the index file
+struct srcMLIndexHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t unitCount;
+    std::uint64_t sourceSize;
+    std::uint64_t sourceHash;
+    std::uint64_t stringsOffset;
+    std::uint64_t stringsSize;
+    std::uint32_t urlOffset;
+    std::uint32_t urlLength;
+    std::int64_t totals[SRCML_INDEX_COUNTS];
+};
+
+// top-level unit in the index file
+struct srcMLIndexUnit {
+    std::uint64_t offset;
+    std::uint64_t length;
+    std::uint32_t filenameOffset;
+    std::uint32_t filenameLength;
+    std::uint32_t languageOffset;
+    std::uint32_t languageLength;
+    std::int64_t counts[SRCML_INDEX_COUNTS];
+};
+
+class srcMLIndex {
+public:
+
+    // path of the sidecar index of the archive
+    static std::string sidecarPath(const std::string& archive);
+
+    // index the srcML archive in memory with jobs threads, and write the index to the path
+    // With check, the archive is also checked for well-formedness.
+    // @return counts of the whole archive
+    static srcFactsCounts build(const std::string& path, const char* data, std::size_t len, int jobs, bool check = false);
+
+    // open the index at the path for the srcML archive in memory
+    srcMLIndex(const std::string& path, const char* data, std::size_t len);
+
+    srcMLIndex(const srcMLIndex&) = delete;
+    srcMLIndex& operator=(const srcMLIndex&) = delete;
+
+    // is the index present and for this archive
+    bool isValid() const;
+
+    // number of top-level units
+    std::size_t size() const;
+
+    // byte offset of the unit start tag in the archive
+    std::uint64_t offset(std::size_t unit) const;
+
+    // byte length of the unit element
+    std::uint64_t length(std::size_t unit) const;
+
+    // unit element in the archive, ready to parse
+    std::string_view source(std::size_t unit) const;
+
+    // filename attribute of the unit
+    std::string_view filename(std::size_t unit) const;
+
+    // language attribute of the unit
+    std::string_view language(std::size_t unit) const;
+
+    // srcFacts counts of the unit
+    srcFactsCounts counts(std::size_t unit) const;
+
+    // srcFacts counts of the whole archive
+    srcFactsCounts totals() const;
+
+    // index of the first unit with the filename, or -1 if none
+    long find(std::string_view name) const;
+
+private:
+
+    // string in the string table
+    std::string_view string(std::uint32_t stringOffset, std::uint32_t stringLength) const;
+
+    std::unique_ptr<MappedFile> file;
+    const srcMLIndexHeader* header = nullptr;
+    const srcMLIndexUnit* units = nullptr;
+    const char* strings = nullptr;
+    const char* archive = nullptr;
+};
+
+#endif
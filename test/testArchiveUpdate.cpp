@@ -0,0 +1,88 @@
+/*
+    testArchiveUpdate.cpp
+
+    Test that the counts of an archive after update() are the same as
+    the counts of a full parse of the edited archive, for edits that
+    add, remove, and rewrite units, including removing the last unit
+    and adding a unit to an archive without units.
+*/
+
+#include "srcFactsArchive.hpp"
+#include <iostream>
+#include <string>
+
+namespace {
+
+    // are the counts the same
+    bool sameCounts(const srcFactsCounts& a, const srcFactsCounts& b) {
+
+        return a.url == b.url && a.textsize == b.textsize && a.loc == b.loc && a.expr_count == b.expr_count &&
+               a.function_count == b.function_count && a.class_count == b.class_count && a.file_count == b.file_count &&
+               a.decl_count == b.decl_count && a.comment_count == b.comment_count && a.return_count == b.return_count &&
+               a.string_count == b.string_count && a.line_comment_count == b.line_comment_count;
+    }
+
+    // is the updated archive the same as a full parse of its contents
+    bool sameArchive(const srcFactsArchive& updated, const std::string& contents, bool check) {
+
+        const srcFactsArchive parsed(contents.data(), contents.size(), 1, check);
+        if (updated.size() != parsed.size() || !sameCounts(updated.totals(), parsed.totals()))
+            return false;
+        for (std::size_t unit = 0; unit < parsed.size(); ++unit)
+            if (updated.offset(unit) != parsed.offset(unit) || updated.length(unit) != parsed.length(unit) ||
+                !sameCounts(updated.counts(unit), parsed.counts(unit)))
+                return false;
+
+        return true;
+    }
+
+    const std::string ROOT = "<unit xmlns=\"http://www.srcML.org/srcML/src\" url=\"root\">";
+    const std::string UNIT_A = "<unit filename=\"a.cpp\"><function><name>f</name>() { <return>return <expr>1</expr>;</return> }</function>\n</unit>";
+    const std::string UNIT_B = "<unit filename=\"b.cpp\"><decl_stmt><decl>int <name>x</name></decl>;</decl_stmt>\n<comment>// c</comment>\n</unit>";
+    const std::string UNIT_C = "<unit filename=\"c.cpp\"><class>class <name>C</name> {};</class>\n\n</unit>";
+
+    // edit the archive, replacing the text at the old position with the new text, and check it against a full parse
+    bool edit(const char* name, srcFactsArchive& archive, std::string& contents, bool check,
+              const std::string& oldText, const std::string& newText) {
+
+        const std::size_t offset = contents.find(oldText);
+        if (offset == std::string::npos) {
+            std::cerr << "testArchiveUpdate: " << name << ": Missing text to edit\n";
+            return false;
+        }
+        contents.replace(offset, oldText.size(), newText);
+        if (!archive.update(contents.data(), contents.size(), offset, oldText.size(), newText.size())) {
+            std::cerr << "testArchiveUpdate: " << name << ": Edit does not match the archive\n";
+            return false;
+        }
+        if (!sameArchive(archive, contents, check)) {
+            std::cerr << "testArchiveUpdate: " << name << (check ? " (checked)" : "") << ": Update differs from a full parse\n";
+            return false;
+        }
+
+        return true;
+    }
+
+    // a sequence of edits, starting from an archive of units a and b
+    bool edits(bool check) {
+
+        std::string contents = ROOT + UNIT_A + UNIT_B + "</unit>\n";
+        srcFactsArchive archive(contents.data(), contents.size(), 1, check);
+
+        return edit("add a unit", archive, contents, check, UNIT_B, UNIT_B + UNIT_C) &&
+               edit("remove a unit", archive, contents, check, UNIT_A, "") &&
+               edit("rewrite a unit", archive, contents, check, "<name>x</name>", "<name>x</name>, <name>y</name>") &&
+               edit("rewrite across units", archive, contents, check, "// c</comment>\n</unit><unit filename=\"c.cpp\">",
+                                                                      "// d</comment>\n</unit>\n<unit filename=\"d.cpp\">") &&
+               edit("remove all units", archive, contents, check, contents.substr(ROOT.size(), contents.size() - ROOT.size() - 8), "") &&
+               edit("add the first unit", archive, contents, check, ROOT, ROOT + UNIT_A) &&
+               edit("remove the last unit", archive, contents, check, UNIT_A, "") &&
+               edit("add units", archive, contents, check, ROOT, ROOT + UNIT_C + UNIT_A) &&
+               edit("rewrite the root", archive, contents, check, "url=\"root\"", "url=\"renamed\"");
+    }
+}
+
+int main() {
+
+    return edits(false) && edits(true) ? 0 : 1;
+}
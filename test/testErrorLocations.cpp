@@ -0,0 +1,102 @@
+/*
+    testErrorLocations.cpp
+
+    Test that the location of a well-formedness error is the same for
+    each shape of handler: one that only counts, one that takes names,
+    and one that takes name IDs and attributes. Each handles its first
+    error by stopping the parse.
+*/
+
+#include "BasicXMLParser.hpp"
+#include <iostream>
+#include <string>
+
+namespace {
+
+    // first error of the parse
+    struct FirstError {
+        long offset = -1;
+        long line = 0;
+        long column = 0;
+
+        // keep the first error, and stop
+        XMLControl handleError(const XMLError& error) {
+
+            offset = error.offset;
+            line = error.line;
+            column = error.column;
+
+            return XMLControl::Stop;
+        }
+    };
+
+    // handler that only counts
+    struct CountHandler : FirstError {
+        long count = 0;
+
+        void handleStartTag() { ++count; }
+        void handleEndTag() { ++count; }
+        void handleAttribute() { ++count; }
+    };
+
+    // handler that takes names
+    struct NameHandler : FirstError {
+        long count = 0;
+
+        void handleStartTag(std::string_view, std::string_view) { ++count; }
+        void handleEndTag(std::string_view, std::string_view) { ++count; }
+        void handleAttribute(std::string_view, std::string_view) { ++count; }
+    };
+
+    // handler that takes name IDs and attributes
+    struct AttributesHandler : FirstError {
+        long count = 0;
+
+        void handleStartTag(int, std::string_view, std::string_view, const XMLAttributes& attributes) { count += 1 + (long) attributes.size(); }
+        void handleEndTag(int, std::string_view, std::string_view) { ++count; }
+    };
+
+    // first error of the document, with the handler
+    template <typename Handler>
+    FirstError firstError(const std::string& document) {
+
+        Handler handler;
+        BasicXMLParser<Handler> parser(handler);
+        parser.checkWellFormed(true);
+        parser.parse(document.data(), document.size());
+
+        return handler;
+    }
+
+    // is the error at the text in the document, for each handler
+    bool errorAt(const char* name, const std::string& document, const std::string& at) {
+
+        const long offset = (long) document.find(at);
+        const FirstError errors[] = { firstError<CountHandler>(document), firstError<NameHandler>(document), firstError<AttributesHandler>(document) };
+        const char* const handlers[] = { "counting", "names", "attributes" };
+        bool same = true;
+        for (int i = 0; i < 3; ++i) {
+            if (errors[i].offset != offset || errors[i].line != errors[0].line || errors[i].column != errors[0].column) {
+                std::cerr << "testErrorLocations: " << name << ": Error with the " << handlers[i] << " handler at offset "
+                          << errors[i].offset << ", line " << errors[i].line << ", column " << errors[i].column << ", not at offset " << offset << '\n';
+                same = false;
+            }
+        }
+
+        return same;
+    }
+
+    const std::string DECLARATION = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n";
+}
+
+int main() {
+
+    bool passed = true;
+    passed = errorAt("mismatched end tag", DECLARATION + "<a>\n  <b>x</bb>\n</a>", "bb>") && passed;
+    passed = errorAt("end tag with no open element", DECLARATION + "<a/>\n</c>", "c>") && passed;
+    passed = errorAt("duplicate attribute", DECLARATION + "<a>\n  <b x=\"1\" y=\"2\"   x=\"3\"/>\n</a>", "x=\"3\"") && passed;
+    passed = errorAt("duplicate namespace", DECLARATION + "<a xmlns:p=\"u\" xmlns:p=\"v\"/>", "xmlns:p=\"v\"") && passed;
+    passed = errorAt("invalid attribute name", DECLARATION + "<a>\n<b x=\"1\" 9y=\"2\"/></a>", "9y") && passed;
+
+    return passed ? 0 : 1;
+}
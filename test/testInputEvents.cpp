@@ -0,0 +1,174 @@
+/*
+    testInputEvents.cpp
+
+    Test that the parser delivers the same events however the input is
+    read: from a mapped file, from a pipe through the read-ahead chunks,
+    and from memory. Events are compared by a hash of their kind and
+    contents, with a count of each kind.
+
+    Usage: testInputEvents [file]
+
+    Without a file, a generated document is used, with text runs that
+    cross chunk boundaries and the padded end of input in memory.
+*/
+
+#include "BasicXMLParser.hpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <cstdint>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+    // hash of the events, with the count of each kind
+    struct EventHash {
+        std::uint64_t hash = 14695981039346656037ULL;
+        long starts = 0;
+        long ends = 0;
+        long attributes = 0;
+        long characters = 0;
+        long other = 0;
+
+        // add the kind and contents of an event
+        void add(char kind, std::string_view contents = std::string_view()) {
+
+            hash = (hash ^ (unsigned char) kind) * 1099511628211ULL;
+            for (const char c : contents)
+                hash = (hash ^ (unsigned char) c) * 1099511628211ULL;
+            hash = (hash ^ 0xff) * 1099511628211ULL;
+        }
+
+        void handleStartTag(std::string_view local_name, std::string_view prefix) { ++starts; add('s', prefix); add(':', local_name); }
+        void handleEndTag(std::string_view local_name, std::string_view prefix) { ++ends; add('e', prefix); add(':', local_name); }
+        void handleAttribute(std::string_view local_name, std::string_view value) { ++attributes; add('a', local_name); add('=', value); }
+        void handleNamespace(std::string_view uri, std::string_view prefix) { ++other; add('n', prefix); add('=', uri); }
+        void handleCDATA(std::string_view characters) { ++other; add('d', characters); }
+        void handleEntity(std::string_view characters) { ++other; add('r', characters); }
+        void handleCharacters(std::string_view characters) { ++this->characters; add('c', characters); }
+        void handleComments(std::string_view comment) { ++other; add('m', comment); }
+
+        bool operator==(const EventHash& other) const {
+
+            return hash == other.hash && starts == other.starts && ends == other.ends && attributes == other.attributes &&
+                   characters == other.characters && this->other == other.other;
+        }
+    };
+
+    // events of the file, mapped
+    EventHash fromFile(const char* filename) {
+
+        EventHash events;
+        BasicXMLParser<EventHash> parser(events);
+        const int fd = open(filename, O_RDONLY);
+        long total = 0;
+        parser.parse(fd, total);
+        close(fd);
+
+        return events;
+    }
+
+    // events of the file, read from a pipe
+    EventHash fromPipe(const std::string& contents) {
+
+        int fds[2];
+        if (pipe(fds) == -1)
+            return EventHash();
+        std::thread writer([&]() {
+
+            // small writes, so the reader sees short reads
+            for (std::size_t pos = 0; pos < contents.size(); pos += 4093) {
+                const std::size_t size = std::min((std::size_t) 4093, contents.size() - pos);
+                if (write(fds[1], contents.data() + pos, size) != (ssize_t) size)
+                    break;
+            }
+            close(fds[1]);
+        });
+        EventHash events;
+        BasicXMLParser<EventHash> parser(events);
+        long total = 0;
+        parser.parse(fds[0], total);
+        writer.join();
+        close(fds[0]);
+
+        return events;
+    }
+
+    // events of the contents, in memory
+    EventHash fromMemory(const std::string& contents) {
+
+        EventHash events;
+        BasicXMLParser<EventHash> parser(events);
+        parser.parse(contents.data(), contents.size());
+
+        return events;
+    }
+
+    // document with text runs across chunk boundaries, and text in the padded end of input
+    std::string generated() {
+
+        std::string document = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n<unit xmlns=\"http://www.srcML.org/srcML/src\">";
+        for (int i = 0; i < 2000; ++i) {
+            document += "<unit filename=\"f" + std::to_string(i) + "\"><expr>";
+            document.append((std::size_t) (i * 97 % 5000), 'x');
+            document += "&lt;\n";
+            document.append((std::size_t) (i * 31 % 700), '\n');
+            document += "</expr><!-- c --><![CDATA[ d ]]></unit>";
+        }
+        document += "<unit><expr>";
+        document.append((std::size_t) ReadAhead::CHUNK_SIZE * 3 + 17, 'y');
+        document += "</expr>\n  tail\n</unit>";
+        document += "</unit>";
+
+        return document;
+    }
+
+    // report the events of one way of reading
+    void report(const char* way, const EventHash& events) {
+
+        std::cerr << "  " << way << ": starts " << events.starts << ", ends " << events.ends << ", attributes " << events.attributes
+                  << ", characters " << events.characters << ", other " << events.other << '\n';
+    }
+}
+
+int main(int argc, char* argv[]) {
+
+    // input from the named file, or generated
+    std::string filename;
+    std::string contents;
+    if (argc > 1) {
+        filename = argv[1];
+        std::ifstream in(filename, std::ios::binary);
+        std::ostringstream out;
+        out << in.rdbuf();
+        contents = out.str();
+    } else {
+        filename = "testInputEvents.xml";
+        contents = generated();
+        std::ofstream(filename, std::ios::binary) << contents;
+    }
+    if (contents.empty()) {
+        std::cerr << "testInputEvents: Unable to read " << filename << '\n';
+        return 1;
+    }
+
+    const EventHash file = fromFile(filename.c_str());
+    const EventHash piped = fromPipe(contents);
+    const EventHash memory = fromMemory(contents);
+    if (argc == 1)
+        std::remove(filename.c_str());
+
+    if (!(file == piped) || !(file == memory)) {
+        std::cerr << "testInputEvents: Events of " << filename << " depend on how it is read\n";
+        report("file", file);
+        report("pipe", piped);
+        report("memory", memory);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,101 @@
+/*
+    xmlChars.hpp
+
+    Table-driven classification of XML characters. A single constexpr
+    table of 256 entries gives the classes of each byte, and is indexed
+    by unsigned char, so bytes of UTF-8 multibyte characters are safe.
+    Unlike isspace(), the classes do not depend on the locale.
+
+    Bytes of UTF-8 multibyte characters, 0x80 and above, are treated
+    as name characters.
+*/
+
+#ifndef INCLUDED_XMLCHARS_HPP
+#define INCLUDED_XMLCHARS_HPP
+
+#include "xmlScan.hpp"
+
+namespace xml_chars {
+
+    // character classes, as bit flags
+    enum : unsigned char {
+        SPACE      = 1 << 0,  // space, tab, newline, carriage return
+        NAME_START = 1 << 1,  // may start a name
+        NAME       = 1 << 2,  // may be in a name
+        NAME_END   = 1 << 3,  // ends a tag name: whitespace, '>', '/'
+    };
+
+    // classes of the character
+    constexpr unsigned char classify(int c) {
+
+        unsigned char classes = 0;
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r')
+            classes |= SPACE | NAME_END;
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == ':' || c >= 0x80)
+            classes |= NAME_START | NAME;
+        if ((c >= '0' && c <= '9') || c == '-' || c == '.')
+            classes |= NAME;
+        if (c == '>' || c == '/')
+            classes |= NAME_END;
+
+        return classes;
+    }
+
+    // table of the classes of each byte
+    struct Table {
+        unsigned char classes[256];
+
+        constexpr Table() : classes() {
+
+            for (int c = 0; c < 256; ++c)
+                classes[c] = classify(c);
+        }
+    };
+
+    inline constexpr Table table;
+
+    // does the character have any of the classes
+    constexpr bool is(char c, unsigned char classes) {
+
+        return (table.classes[(unsigned char) c] & classes) != 0;
+    }
+}
+
+// is XML whitespace
+constexpr bool isXMLSpace(char c) {
+
+    return xml_chars::is(c, xml_chars::SPACE);
+}
+
+// can start an XML name
+constexpr bool isXMLNameStart(char c) {
+
+    return xml_chars::is(c, xml_chars::NAME_START);
+}
+
+// can be in an XML name
+constexpr bool isXMLNameChar(char c) {
+
+    return xml_chars::is(c, xml_chars::NAME);
+}
+
+// ends a tag name
+constexpr bool isXMLNameEnd(char c) {
+
+    return xml_chars::is(c, xml_chars::NAME_END);
+}
+
+// skip XML whitespace in [first, last), returning the first other character, or last
+// Mostly none or one space, so only longer runs use the vector kernel
+inline const char* skipSpace(const char* first, const char* last) {
+
+    if (first == last || !isXMLSpace(*first))
+        return first;
+    ++first;
+    if (first == last || !isXMLSpace(*first))
+        return first;
+
+    return scanNotSpace(first, last);
+}
+
+#endif
@@ -0,0 +1,160 @@
+/*
+    xmlEntities.hpp
+
+    Decoding of XML references to UTF-8: the predefined entities
+    &lt; &gt; &amp; &quot; &apos;, and the character references
+    &#ddd; and &#xhhh;. A '&' that does not start a complete reference
+    is left as is.
+
+    Decoding is lazy. The parser passes attribute values, and the text
+    between references, as views into the input. A handler that needs
+    the decoded form of a value calls decodeXMLText(), which returns a
+    view with no '&' as is, with no copy.
+*/
+
+#ifndef INCLUDED_XMLENTITIES_HPP
+#define INCLUDED_XMLENTITIES_HPP
+
+#include "xmlScan.hpp"
+
+#include <string>
+#include <string_view>
+#include <cstring>
+
+namespace xml_entities {
+
+    // predefined entity, with the ';' in the name
+    struct Predefined {
+        const char* name;
+        int size;
+        char character;
+    };
+
+    inline constexpr Predefined predefined[] = {
+        { "lt;",   3, '<'  },
+        { "gt;",   3, '>'  },
+        { "amp;",  4, '&'  },
+        { "quot;", 5, '"'  },
+        { "apos;", 5, '\'' },
+    };
+
+    // value of the digit in the base, or -1 if it is not a digit
+    constexpr int digit(char c, int base) {
+
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (base == 16 && c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (base == 16 && c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+
+        return -1;
+    }
+}
+
+// longest reference that is decoded, so a reference not complete in a shorter buffer may be in the next
+constexpr int XML_MAX_REFERENCE = 32;
+
+// most bytes of the UTF-8 of a reference
+constexpr int XML_MAX_UTF8 = 4;
+
+// encode the character as UTF-8
+// @return number of bytes, or 0 if it is not an XML character
+inline int encodeUTF8(unsigned long code, char* out) {
+
+    if (code == 0 || (code >= 0xD800 && code <= 0xDFFF) || code > 0x10FFFF)
+        return 0;
+    if (code < 0x80) {
+        out[0] = (char) code;
+        return 1;
+    }
+    if (code < 0x800) {
+        out[0] = (char) (0xC0 | (code >> 6));
+        out[1] = (char) (0x80 | (code & 0x3F));
+        return 2;
+    }
+    if (code < 0x10000) {
+        out[0] = (char) (0xE0 | (code >> 12));
+        out[1] = (char) (0x80 | ((code >> 6) & 0x3F));
+        out[2] = (char) (0x80 | (code & 0x3F));
+        return 3;
+    }
+    out[0] = (char) (0xF0 | (code >> 18));
+    out[1] = (char) (0x80 | ((code >> 12) & 0x3F));
+    out[2] = (char) (0x80 | ((code >> 6) & 0x3F));
+    out[3] = (char) (0x80 | (code & 0x3F));
+    return 4;
+}
+
+// decode the reference starting with the '&' at first into at most XML_MAX_UTF8 characters
+// @return end of the reference, or first if [first, last) does not start with a complete reference
+inline const char* decodeXMLReference(const char* first, const char* last, char* characters, int& size) {
+
+    const char* pc = first + 1;
+    if (pc == last)
+        return first;
+
+    // predefined entity
+    if (*pc != '#') {
+        for (const auto& entity : xml_entities::predefined) {
+            if (last - pc >= entity.size && std::memcmp(pc, entity.name, entity.size) == 0) {
+                characters[0] = entity.character;
+                size = 1;
+                return pc + entity.size;
+            }
+        }
+        return first;
+    }
+
+    // character reference, decimal or hexadecimal
+    ++pc;
+    int base = 10;
+    if (pc != last && *pc == 'x') {
+        base = 16;
+        ++pc;
+    }
+    const char* const digits = pc;
+    unsigned long code = 0;
+    for (int value = 0; pc != last && (value = xml_entities::digit(*pc, base)) != -1; ++pc) {
+        code = code * base + value;
+        if (code > 0x10FFFF)
+            return first;
+    }
+    if (pc == digits || pc == last || *pc != ';')
+        return first;
+    size = encodeUTF8(code, characters);
+    if (size == 0)
+        return first;
+
+    return pc + 1;
+}
+
+// text with the references decoded, into the buffer if there are any
+inline std::string_view decodeXMLText(std::string_view text, std::string& buffer) {
+
+    const char* const last = text.data() + text.size();
+    const char* pc = scanChar(text.data(), last, '&');
+    if (pc == last)
+        return text;
+
+    buffer.assign(text.data(), pc);
+    while (pc != last) {
+        char characters[XML_MAX_UTF8];
+        int size = 0;
+        const char* end = decodeXMLReference(pc, last, characters, size);
+        if (end != pc) {
+            buffer.append(characters, size);
+            pc = end;
+        } else {
+            buffer.push_back('&');
+            ++pc;
+        }
+        const char* next = scanChar(pc, last, '&');
+        buffer.append(pc, next);
+        pc = next;
+    }
+
+    return buffer;
+}
+
+#endif
@@ -0,0 +1,467 @@
+/*
+    xmlScan.cpp
+
+    Implementation file for the XML scanning kernels.
+
+    Vector loops only load whole blocks inside [first, last), and the
+    remainder is finished by the scalar version, so no kernel reads
+    past the end of the range.
+*/
+
+#include "xmlScan.hpp"
+#include "xmlChars.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define XMLSCAN_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(XMLSCAN_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define XMLSCAN_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+    using scanChar_t = const char* (*)(const char*, const char*, char);
+    using scanEither_t = const char* (*)(const char*, const char*, char, char);
+    using scanEitherCount_t = const char* (*)(const char*, const char*, char, char, char, long&);
+    using scanSequence_t = const char* (*)(const char*, const char*, const char*);
+    using scanNotSpace_t = const char* (*)(const char*, const char*);
+    using countChar_t = long (*)(const char*, const char*, char);
+
+    // set of kernels for one instruction set
+    struct ScanKernels {
+        const char* name;
+        scanChar_t scanChar;
+        scanEither_t scanEither;
+        scanEitherCount_t scanEitherCount;
+        scanSequence_t scanSequence;
+        scanNotSpace_t scanNotSpace;
+        countChar_t countChar;
+    };
+
+    // index of the lowest set bit, mask is not zero
+    inline int firstBit(unsigned int mask) {
+
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return (int) index;
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+
+    // number of set bits
+    inline int bitCount(unsigned int mask) {
+
+#if defined(_MSC_VER)
+        return (int) __popcnt(mask);
+#else
+        return __builtin_popcount(mask);
+#endif
+    }
+
+    // scalar find of character c
+    const char* scanCharScalar(const char* first, const char* last, char c) {
+
+        const void* p = std::memchr(first, c, last - first);
+        return p != nullptr ? static_cast<const char*>(p) : last;
+    }
+
+    // scalar find of character c1 or c2
+    const char* scanEitherScalar(const char* first, const char* last, char c1, char c2) {
+
+        for (; first != last; ++first)
+            if (*first == c1 || *first == c2)
+                return first;
+
+        return last;
+    }
+
+    // scalar find of character c1 or c2, counting the character counted before it
+    const char* scanEitherCountScalar(const char* first, const char* last, char c1, char c2, char counted, long& count) {
+
+        for (; first != last; ++first) {
+            if (*first == c1 || *first == c2)
+                return first;
+            count += *first == counted;
+        }
+
+        return last;
+    }
+
+    // scalar find of a three character sequence
+    const char* scanSequenceScalar(const char* first, const char* last, const char* seq) {
+
+        while (last - first >= 3) {
+            first = scanCharScalar(first, last - 2, seq[0]);
+            if (first == last - 2)
+                break;
+            if (first[1] == seq[1] && first[2] == seq[2])
+                return first;
+            ++first;
+        }
+
+        return last;
+    }
+
+    // scalar find of a character that is not whitespace
+    const char* scanNotSpaceScalar(const char* first, const char* last) {
+
+        while (first != last && isXMLSpace(*first))
+            ++first;
+
+        return first;
+    }
+
+    // scalar count of character c
+    long countCharScalar(const char* first, const char* last, char c) {
+
+        long count = 0;
+        for (; first != last; ++first)
+            count += *first == c;
+
+        return count;
+    }
+
+    const ScanKernels scalarKernels = { "scalar", scanCharScalar, scanEitherScalar, scanEitherCountScalar, scanSequenceScalar, scanNotSpaceScalar, countCharScalar };
+
+#if defined(XMLSCAN_SSE2)
+
+    // SSE2 find of character c
+    const char* scanCharSSE2(const char* first, const char* last, char c) {
+
+        const __m128i vc = _mm_set1_epi8(c);
+        for (; last - first >= 16; first += 16) {
+            const __m128i block = _mm_loadu_si128((const __m128i*) first);
+            const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, vc));
+            if (mask != 0)
+                return first + firstBit(mask);
+        }
+
+        return scanCharScalar(first, last, c);
+    }
+
+    // SSE2 find of character c1 or c2
+    const char* scanEitherSSE2(const char* first, const char* last, char c1, char c2) {
+
+        const __m128i vc1 = _mm_set1_epi8(c1);
+        const __m128i vc2 = _mm_set1_epi8(c2);
+        for (; last - first >= 16; first += 16) {
+            const __m128i block = _mm_loadu_si128((const __m128i*) first);
+            const int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, vc1), _mm_cmpeq_epi8(block, vc2)));
+            if (mask != 0)
+                return first + firstBit(mask);
+        }
+
+        return scanEitherScalar(first, last, c1, c2);
+    }
+
+    // SSE2 find of character c1 or c2, counting the character counted before it
+    const char* scanEitherCountSSE2(const char* first, const char* last, char c1, char c2, char counted, long& count) {
+
+        const __m128i vc1 = _mm_set1_epi8(c1);
+        const __m128i vc2 = _mm_set1_epi8(c2);
+        const __m128i vcounted = _mm_set1_epi8(counted);
+        for (; last - first >= 16; first += 16) {
+            const __m128i block = _mm_loadu_si128((const __m128i*) first);
+            const unsigned int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, vc1), _mm_cmpeq_epi8(block, vc2)));
+            const unsigned int countedmask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, vcounted));
+            if (mask != 0) {
+                const int pos = firstBit(mask);
+                count += bitCount(countedmask & ((1u << pos) - 1));
+                return first + pos;
+            }
+            count += bitCount(countedmask);
+        }
+
+        return scanEitherCountScalar(first, last, c1, c2, counted, count);
+    }
+
+    // SSE2 find of a three character sequence
+    // Candidates match both the first and last character, then are verified
+    const char* scanSequenceSSE2(const char* first, const char* last, const char* seq) {
+
+        const __m128i vfirst = _mm_set1_epi8(seq[0]);
+        const __m128i vlast = _mm_set1_epi8(seq[2]);
+        for (; last - first >= 16 + 2; first += 16) {
+            const __m128i blockfirst = _mm_loadu_si128((const __m128i*) first);
+            const __m128i blocklast = _mm_loadu_si128((const __m128i*) (first + 2));
+            unsigned int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(blockfirst, vfirst), _mm_cmpeq_epi8(blocklast, vlast)));
+            while (mask != 0) {
+                const int pos = firstBit(mask);
+                if (first[pos + 1] == seq[1])
+                    return first + pos;
+                mask &= mask - 1;
+            }
+        }
+
+        return scanSequenceScalar(first, last, seq);
+    }
+
+    // SSE2 find of a character that is not whitespace
+    const char* scanNotSpaceSSE2(const char* first, const char* last) {
+
+        const __m128i vspace = _mm_set1_epi8(' ');
+        const __m128i vtab = _mm_set1_epi8('\t');
+        const __m128i vnewline = _mm_set1_epi8('\n');
+        const __m128i vreturn = _mm_set1_epi8('\r');
+        for (; last - first >= 16; first += 16) {
+            const __m128i block = _mm_loadu_si128((const __m128i*) first);
+            const __m128i space = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, vspace), _mm_cmpeq_epi8(block, vtab)),
+                                               _mm_or_si128(_mm_cmpeq_epi8(block, vnewline), _mm_cmpeq_epi8(block, vreturn)));
+            const unsigned int mask = ~_mm_movemask_epi8(space) & 0xFFFFu;
+            if (mask != 0)
+                return first + firstBit(mask);
+        }
+
+        return scanNotSpaceScalar(first, last);
+    }
+
+    // SSE2 count of character c
+    // Matches are summed per byte lane, and the lanes are added before they can overflow
+    long countCharSSE2(const char* first, const char* last, char c) {
+
+        const __m128i vc = _mm_set1_epi8(c);
+        long count = 0;
+        while (last - first >= 16) {
+            __m128i lanes = _mm_setzero_si128();
+            for (int i = 0; i < 255 && last - first >= 16; ++i, first += 16) {
+                const __m128i block = _mm_loadu_si128((const __m128i*) first);
+                lanes = _mm_sub_epi8(lanes, _mm_cmpeq_epi8(block, vc));
+            }
+            const __m128i sums = _mm_sad_epu8(lanes, _mm_setzero_si128());
+            count += _mm_cvtsi128_si32(sums) + _mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+        }
+
+        return count + countCharScalar(first, last, c);
+    }
+
+    const ScanKernels sse2Kernels = { "sse2", scanCharSSE2, scanEitherSSE2, scanEitherCountSSE2, scanSequenceSSE2, scanNotSpaceSSE2, countCharSSE2 };
+
+#endif
+
+#if defined(XMLSCAN_AVX2)
+
+    // AVX2 find of character c
+    __attribute__((target("avx2")))
+    const char* scanCharAVX2(const char* first, const char* last, char c) {
+
+        const __m256i vc = _mm256_set1_epi8(c);
+        for (; last - first >= 32; first += 32) {
+            const __m256i block = _mm256_loadu_si256((const __m256i*) first);
+            const unsigned int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, vc));
+            if (mask != 0)
+                return first + firstBit(mask);
+        }
+
+        return scanCharSSE2(first, last, c);
+    }
+
+    // AVX2 find of character c1 or c2
+    __attribute__((target("avx2")))
+    const char* scanEitherAVX2(const char* first, const char* last, char c1, char c2) {
+
+        const __m256i vc1 = _mm256_set1_epi8(c1);
+        const __m256i vc2 = _mm256_set1_epi8(c2);
+        for (; last - first >= 32; first += 32) {
+            const __m256i block = _mm256_loadu_si256((const __m256i*) first);
+            const unsigned int mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(block, vc1), _mm256_cmpeq_epi8(block, vc2)));
+            if (mask != 0)
+                return first + firstBit(mask);
+        }
+
+        return scanEitherSSE2(first, last, c1, c2);
+    }
+
+    // AVX2 find of character c1 or c2, counting the character counted before it
+    __attribute__((target("avx2,popcnt")))
+    const char* scanEitherCountAVX2(const char* first, const char* last, char c1, char c2, char counted, long& count) {
+
+        const __m256i vc1 = _mm256_set1_epi8(c1);
+        const __m256i vc2 = _mm256_set1_epi8(c2);
+        const __m256i vcounted = _mm256_set1_epi8(counted);
+        for (; last - first >= 32; first += 32) {
+            const __m256i block = _mm256_loadu_si256((const __m256i*) first);
+            const unsigned int mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(block, vc1), _mm256_cmpeq_epi8(block, vc2)));
+            const unsigned int countedmask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, vcounted));
+            if (mask != 0) {
+                const int pos = firstBit(mask);
+                count += __builtin_popcount(countedmask & ((1u << pos) - 1));
+                return first + pos;
+            }
+            count += __builtin_popcount(countedmask);
+        }
+
+        return scanEitherCountSSE2(first, last, c1, c2, counted, count);
+    }
+
+    // AVX2 find of a three character sequence
+    __attribute__((target("avx2")))
+    const char* scanSequenceAVX2(const char* first, const char* last, const char* seq) {
+
+        const __m256i vfirst = _mm256_set1_epi8(seq[0]);
+        const __m256i vlast = _mm256_set1_epi8(seq[2]);
+        for (; last - first >= 32 + 2; first += 32) {
+            const __m256i blockfirst = _mm256_loadu_si256((const __m256i*) first);
+            const __m256i blocklast = _mm256_loadu_si256((const __m256i*) (first + 2));
+            unsigned int mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(blockfirst, vfirst), _mm256_cmpeq_epi8(blocklast, vlast)));
+            while (mask != 0) {
+                const int pos = firstBit(mask);
+                if (first[pos + 1] == seq[1])
+                    return first + pos;
+                mask &= mask - 1;
+            }
+        }
+
+        return scanSequenceSSE2(first, last, seq);
+    }
+
+    // AVX2 find of a character that is not whitespace
+    __attribute__((target("avx2")))
+    const char* scanNotSpaceAVX2(const char* first, const char* last) {
+
+        const __m256i vspace = _mm256_set1_epi8(' ');
+        const __m256i vtab = _mm256_set1_epi8('\t');
+        const __m256i vnewline = _mm256_set1_epi8('\n');
+        const __m256i vreturn = _mm256_set1_epi8('\r');
+        for (; last - first >= 32; first += 32) {
+            const __m256i block = _mm256_loadu_si256((const __m256i*) first);
+            const __m256i space = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, vspace), _mm256_cmpeq_epi8(block, vtab)),
+                                                  _mm256_or_si256(_mm256_cmpeq_epi8(block, vnewline), _mm256_cmpeq_epi8(block, vreturn)));
+            const unsigned int mask = ~(unsigned int) _mm256_movemask_epi8(space);
+            if (mask != 0)
+                return first + firstBit(mask);
+        }
+
+        return scanNotSpaceSSE2(first, last);
+    }
+
+    // AVX2 count of character c
+    __attribute__((target("avx2")))
+    long countCharAVX2(const char* first, const char* last, char c) {
+
+        const __m256i vc = _mm256_set1_epi8(c);
+        long count = 0;
+        while (last - first >= 32) {
+            __m256i lanes = _mm256_setzero_si256();
+            for (int i = 0; i < 255 && last - first >= 32; ++i, first += 32) {
+                const __m256i block = _mm256_loadu_si256((const __m256i*) first);
+                lanes = _mm256_sub_epi8(lanes, _mm256_cmpeq_epi8(block, vc));
+            }
+            const __m256i sums = _mm256_sad_epu8(lanes, _mm256_setzero_si256());
+            count += _mm256_extract_epi64(sums, 0) + _mm256_extract_epi64(sums, 1)
+                   + _mm256_extract_epi64(sums, 2) + _mm256_extract_epi64(sums, 3);
+        }
+
+        return count + countCharSSE2(first, last, c);
+    }
+
+    const ScanKernels avx2Kernels = { "avx2", scanCharAVX2, scanEitherAVX2, scanEitherCountAVX2, scanSequenceAVX2, scanNotSpaceAVX2, countCharAVX2 };
+
+#endif
+
+    // is the instruction set supported by this CPU
+    bool supports(const char* name) {
+
+        if (std::strcmp(name, "scalar") == 0)
+            return true;
+#if defined(XMLSCAN_SSE2)
+        if (std::strcmp(name, "sse2") == 0)
+            return true;
+#endif
+#if defined(XMLSCAN_AVX2)
+        if (std::strcmp(name, "avx2") == 0) {
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+        }
+#endif
+        return false;
+    }
+
+    // best kernels for this CPU, unless overridden by XMLSCAN
+    ScanKernels selectKernels() {
+
+        const ScanKernels* candidates[] = {
+#if defined(XMLSCAN_AVX2)
+            &avx2Kernels,
+#endif
+#if defined(XMLSCAN_SSE2)
+            &sse2Kernels,
+#endif
+            &scalarKernels,
+        };
+
+        // requested kernels, when supported
+        const char* requested = std::getenv("XMLSCAN");
+        if (requested != nullptr)
+            for (const ScanKernels* kernels : candidates)
+                if (std::strcmp(requested, kernels->name) == 0 && supports(kernels->name))
+                    return *kernels;
+
+        // best supported kernels
+        for (const ScanKernels* kernels : candidates)
+            if (supports(kernels->name))
+                return *kernels;
+
+        return scalarKernels;
+    }
+
+    // kernels selected on first use, so scanning from a static initializer in another file is safe
+    const ScanKernels& kernels() {
+
+        static const ScanKernels selected = selectKernels();
+        return selected;
+    }
+}
+
+// find the first character c in [first, last), or last
+const char* scanChar(const char* first, const char* last, char c) {
+
+    return kernels().scanChar(first, last, c);
+}
+
+// find the first character c1 or c2 in [first, last), or last
+const char* scanEither(const char* first, const char* last, char c1, char c2) {
+
+    return kernels().scanEither(first, last, c1, c2);
+}
+
+// find the first character c1 or c2 in [first, last), or last, adding the number of the character counted before it to count
+const char* scanEitherCount(const char* first, const char* last, char c1, char c2, char counted, long& count) {
+
+    return kernels().scanEitherCount(first, last, c1, c2, counted, count);
+}
+
+// find the first occurrence of the three characters seq in [first, last), or last
+const char* scanSequence(const char* first, const char* last, const char* seq) {
+
+    return kernels().scanSequence(first, last, seq);
+}
+
+// find the first character that is not XML whitespace in [first, last), or last
+const char* scanNotSpace(const char* first, const char* last) {
+
+    return kernels().scanNotSpace(first, last);
+}
+
+// number of the character c in [first, last)
+long countChar(const char* first, const char* last, char c) {
+
+    return kernels().countChar(first, last, c);
+}
+
+// name of the selected kernels
+const char* scanKernelName() {
+
+    return kernels().name;
+}
@@ -0,0 +1,34 @@
+/*
+    xmlScan.hpp
+
+    Scanning kernels for XML delimiters shared by the parsers.
+    SSE2 and AVX2 versions are selected at runtime from the CPU,
+    with a portable scalar fallback. Setting the environment variable
+    XMLSCAN to "scalar", "sse2", or "avx2" overrides the selection.
+*/
+
+#ifndef INCLUDED_XMLSCAN_HPP
+#define INCLUDED_XMLSCAN_HPP
+
+// find the first character c in [first, last), or last
+const char* scanChar(const char* first, const char* last, char c);
+
+// find the first character c1 or c2 in [first, last), or last
+const char* scanEither(const char* first, const char* last, char c1, char c2);
+
+// find the first character c1 or c2 in [first, last), or last, adding the number of the character counted before it to count
+const char* scanEitherCount(const char* first, const char* last, char c1, char c2, char counted, long& count);
+
+// find the first occurrence of the three characters seq in [first, last), or last
+const char* scanSequence(const char* first, const char* last, const char* seq);
+
+// find the first character that is not XML whitespace in [first, last), or last
+const char* scanNotSpace(const char* first, const char* last);
+
+// number of the character c in [first, last)
+long countChar(const char* first, const char* last, char c);
+
+// name of the selected kernels
+const char* scanKernelName();
+
+#endif
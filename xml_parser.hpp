@@ -2,80 +2,59 @@
     xml_parser.hpp
 
     Declaration file for xml parsing
+
+    Free-function front-end of the tokenizer core in BasicXMLParser.hpp,
+    the same core as XMLParser and XMLReader. The handler is a template
+    parameter, so the parse loop, the scanners, and the handler calls
+    are compiled together into the caller.
 */
 
 #ifndef INCLUDED_XML_PARSER_HPP
 #define INCLUDED_XML_PARSER_HPP
-#include <string>
-#include <algorithm>
-
-// check if declaration
-bool isXMLDeclaration(std::string::const_iterator pc);
-
-// check if end tag
-bool isXMLEndTag(std::string::const_iterator pc);
-
-// check if start tag
-bool isXMLStartTag(std::string::const_iterator pc);
-
-// check if namespace
-bool isXMLNamespace(std::string::const_iterator& pc, std::string::const_iterator endpc,  bool intag);
-
-// check if attribute
-bool isXMLAttribute(std::string::const_iterator pc, bool intag);
-
-// check if CDATA
-bool isXMLCData(std::string::const_iterator pc);
-
-// check if comment
-bool isXMLComment(std::string::const_iterator pc);
-
-// check if characters before XML
-bool isBeforeXML(std::string::const_iterator pc, int depth);
-
-// check if entity
-bool isXMLEntity(std::string::const_iterator pc);
-
-// check if characters
-bool isXMLCharacters(std::string::const_iterator pc);
-
-// parse xml declaration
-std::string::const_iterator parseXMLDeclaration(std::string::const_iterator pc, std::string& buffer, long& total);
-
-// parse required xml version
-std::string::const_iterator parseXMLVersion(std::string::const_iterator pc,  std::string& buffer, std::string::const_iterator& pnameend, std::string::const_iterator& pvalueend);
 
-// parse encoding
-std::string::const_iterator parseXMLEncoding(std::string::const_iterator pc,  std::string& buffer, std::string::const_iterator& pnameend, std::string::const_iterator& pvalueend);
+#include "BasicXMLParser.hpp"
 
-// parse standalone
-std::string::const_iterator parseXMLStandalone(std::string::const_iterator pc,  std::string& buffer, std::string::const_iterator& pnameend, std::string::const_iterator& pvalueend);
+#include <cstddef>
 
-// parse xml end tag
-std::string::const_iterator parseXMLEndTag(std::string::const_iterator pc, std::string& buffer, long& total, int& depth);
+// number of events of each kind
+struct XMLEventCounts {
+    long declarations = 0;
+    long startTags = 0;
+    long endTags = 0;
+    long attributes = 0;
+    long namespaces = 0;
+    long CDATA = 0;
+    long entities = 0;
+    long characters = 0;
+    long comments = 0;
 
-// parse xml start tag
-std::string::const_iterator parseXMLStartTag(std::string::const_iterator pc, std::string& buffer, long& total, std::string& local_name, int& depth, bool& intag);
+    // number of events of all kinds
+    long events() const {
 
-// parse xml namespace
-std::string::const_iterator parseXMLNamespace(std::string::const_iterator pc, std::string& buffer, bool& intag);
+        return declarations + startTags + endTags + attributes + namespaces + CDATA + entities + characters + comments;
+    }
+};
 
-// parse xml attribute
-std::string::const_iterator parseXMLAttribute(std::string::const_iterator pc, std::string& buffer, bool& intag, std::string& local_name, std::string& value);
+// parse XML from the file descriptor with the handler
+template <typename Handler>
+void parseXML(int fd, Handler& handler, long& total) {
 
-// parse xml CDATA
-std::string::const_iterator parseXMLCDATA(std::string::const_iterator pc, std::string& buffer, std::string& characters, long& total);
+    BasicXMLParser<Handler> parser(handler);
+    parser.parse(fd, total);
+}
 
-// parse xml comment
-std::string::const_iterator parseXMLComment(std::string::const_iterator pc, std::string& buffer, long total);
+// parse XML in memory with the handler
+template <typename Handler>
+void parseXML(const char* data, std::size_t len, Handler& handler) {
 
-// parse characters before xml
-std::string::const_iterator parseBeforeXML(std::string::const_iterator pc, std::string& buffer);
+    BasicXMLParser<Handler> parser(handler);
+    parser.parse(data, len);
+}
 
-// parse xml entity reference
-std::string::const_iterator parseXMLEntity(std::string::const_iterator pc, std::string& buffer, long total, std::string& characters);
+// count the events of XML from the file descriptor
+XMLEventCounts countXMLEvents(int fd, long& total);
 
-// parse xml characters
-std::string::const_iterator parseXMLCharacters(std::string::const_iterator pc, std::string& buffer, std::string& characters);
+// count the events of XML in memory
+XMLEventCounts countXMLEvents(const char* data, std::size_t len);
 
 #endif
@@ -0,0 +1,404 @@
+/*
+    xmlbench.cpp
+
+    Throughput benchmarks of the XML parsers. Each parser is run
+    repeatedly on demo.xml, or other named inputs, and on generated
+    synthetic inputs: tag-heavy, text-heavy, attribute-heavy,
+    CDATA-heavy, and deeply nested.
+
+    Parsers:
+    * srcFacts and xmlstats, run as programs
+    * XMLParser with no handlers
+    * XMLReader, pulling every token
+    * XMLDocument, building the DOM
+    * the free-function front-end in xml_parser.cpp, counting events
+
+    Reports MB/s, events/s, and ns/event from the median time as a
+    Markdown table, and all of the run statistics as JSON.
+
+    Usage: xmlbench [--runs N] [--size MB] [--output file.json]
+                    [--srcfacts path] [--xmlstats path] [file.xml ...]
+*/
+
+#include "XMLParser.hpp"
+#include "XMLReader.hpp"
+#include "XMLDocument.hpp"
+#include "xml_parser.hpp"
+#include "MappedFile.hpp"
+#include "xmlScan.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <functional>
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+
+#if !defined(_MSC_VER)
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+namespace {
+
+    // counts all events, for events/s
+    class EventCounter {
+    public:
+
+        void handleDeclaration(std::string_view version, std::string_view encoding, std::string_view standalone) { ++events; }
+
+        void handleStartTag(std::string_view local_name, std::string_view prefix) { ++events; }
+
+        void handleEndTag(std::string_view local_name, std::string_view prefix) { ++events; }
+
+        void handleAttribute(std::string_view local_name, std::string_view value) { ++events; }
+
+        void handleNamespace(std::string_view uri, std::string_view prefix) { ++events; }
+
+        void handleCDATA(std::string_view characters) { ++events; }
+
+        void handleEntity(std::string_view characters) { ++events; }
+
+        void handleCharacters(std::string_view characters) { ++events; }
+
+        void handleComments(std::string_view comment) { ++events; }
+
+        long events = 0;
+    };
+
+    // benchmark input file
+    struct Input {
+        std::string name;
+        std::string path;
+        long bytes = 0;
+        long events = 0;
+    };
+
+    // statistics of the run times of one parser on one input
+    struct Result {
+        std::string parser;
+        const Input* input;
+        std::vector<double> seconds;
+        double median = 0;
+        double mean = 0;
+        double variance = 0;
+        double min = 0;
+        double max = 0;
+    };
+
+    // parser under benchmark, run once on the input
+    struct Parser {
+        std::string name;
+        std::function<bool(const Input&)> run;
+    };
+}
+
+// generate a synthetic input of about size bytes, with the element repeated
+static void generate(const std::string& path, std::size_t size, const std::function<void(std::string&, int)>& element) {
+
+    std::string contents = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n";
+    contents += "<bench xmlns=\"http://www.example.com/bench\" xmlns:b=\"http://www.example.com/bench/b\">\n";
+    for (int i = 0; contents.size() < size; ++i)
+        element(contents, i);
+    contents += "</bench>\n";
+
+    std::ofstream out(path, std::ios::binary);
+    out << contents;
+    if (!out) {
+        std::cerr << "xmlbench: Unable to write " << path << '\n';
+        exit(1);
+    }
+}
+
+// generate the synthetic inputs, each of about size bytes
+static std::vector<Input> generateInputs(std::size_t size) {
+
+    std::vector<Input> inputs;
+
+    // many small elements, empty and with short content
+    inputs.push_back({ "tag-heavy", "bench-tags.xml" });
+    generate(inputs.back().path, size, [] (std::string& s, int i) {
+
+        s += "<a><b/><b:c>x</b:c><d><e/></d></a>\n";
+    });
+
+    // long runs of text with a few entities
+    inputs.push_back({ "text-heavy", "bench-text.xml" });
+    generate(inputs.back().path, size, [] (std::string& s, int i) {
+
+        s += "<p>";
+        for (int word = 0; word < 200; ++word)
+            s += (word % 50 == 49) ? "a &lt; b &amp;&amp; c &gt; d\n" : "lorem ipsum ";
+        s += "</p>\n";
+    });
+
+    // elements with many attributes
+    inputs.push_back({ "attribute-heavy", "bench-attributes.xml" });
+    generate(inputs.back().path, size, [] (std::string& s, int i) {
+
+        s += "<e id=\"" + std::to_string(i) + "\" type=\"string\" b:kind=\"line\" name=\"element\""
+             " file=\"src/bench.cpp\" line=\"42\" column=\"7\" language=\"C++\"/>\n";
+    });
+
+    // CDATA sections with markup characters
+    inputs.push_back({ "CDATA-heavy", "bench-cdata.xml" });
+    generate(inputs.back().path, size, [] (std::string& s, int i) {
+
+        s += "<c><![CDATA[";
+        for (int line = 0; line < 20; ++line)
+            s += "if (a < b && b > c) { return a & b; } // <not> a tag ]\n";
+        s += "]]></c>\n";
+    });
+
+    // deep nesting, with text at the bottom
+    inputs.push_back({ "deeply-nested", "bench-nested.xml" });
+    generate(inputs.back().path, size, [] (std::string& s, int i) {
+
+        const int DEPTH = 500;
+        for (int depth = 0; depth < DEPTH; ++depth)
+            s += "<n>";
+        s += "leaf";
+        for (int depth = 0; depth < DEPTH; ++depth)
+            s += "</n>";
+        s += '\n';
+    });
+
+    return inputs;
+}
+
+// size and number of events of the input
+static bool measureInput(Input& input) {
+
+    const int fd = open(input.path.c_str(), O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    MappedFile file(fd);
+    if (!file.isMapped()) {
+        close(fd);
+        return false;
+    }
+    EventCounter counter;
+    BasicXMLParser<EventCounter> parser(counter);
+    parser.parse(file.data(), file.size());
+    input.bytes = (long) file.size();
+    input.events = counter.events;
+    close(fd);
+
+    return true;
+}
+
+// make the input the standard input, at its start
+static bool redirectInput(const Input& input) {
+
+    const int fd = open(input.path.c_str(), O_RDONLY);
+    if (fd == -1)
+        return false;
+    dup2(fd, 0);
+    close(fd);
+
+    return true;
+}
+
+// run the program on the input, with the output discarded
+static bool runProgram(const std::string& program, const Input& input) {
+
+#if !defined(_MSC_VER)
+    const pid_t pid = fork();
+    if (pid == -1)
+        return false;
+
+    if (pid == 0) {
+        const int null = open("/dev/null", O_WRONLY);
+        dup2(null, 1);
+        execl(program.c_str(), program.c_str(), input.path.c_str(), (char*) nullptr);
+        _exit(127);
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#else
+    return false;
+#endif
+}
+
+// median, mean, variance, and range of the run times
+static void summarize(Result& result) {
+
+    std::vector<double> sorted = result.seconds;
+    std::sort(sorted.begin(), sorted.end());
+    const std::size_t n = sorted.size();
+    result.median = n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+    result.mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / n;
+    result.variance = 0;
+    for (const double seconds : sorted)
+        result.variance += (seconds - result.mean) * (seconds - result.mean);
+    result.variance = n > 1 ? result.variance / (n - 1) : 0;
+    result.min = sorted.front();
+    result.max = sorted.back();
+}
+
+// JSON string with quotes and escapes
+static std::string quoted(std::string_view s) {
+
+    std::string out = "\"";
+    for (const char c : s) {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        out += c;
+    }
+    out += '"';
+
+    return out;
+}
+
+// write the results as JSON
+static void writeJSON(const std::string& path, int runs, const std::vector<Result>& results) {
+
+    std::ofstream out(path);
+    out.precision(9);
+    out << "{\n";
+    out << "  \"runs\": " << runs << ",\n";
+    out << "  \"scan_kernels\": " << quoted(scanKernelName()) << ",\n";
+    out << "  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& result = results[i];
+        out << "    {\n";
+        out << "      \"parser\": " << quoted(result.parser) << ",\n";
+        out << "      \"input\": " << quoted(result.input->name) << ",\n";
+        out << "      \"bytes\": " << result.input->bytes << ",\n";
+        out << "      \"events\": " << result.input->events << ",\n";
+        out << "      \"seconds\": [";
+        for (std::size_t run = 0; run < result.seconds.size(); ++run)
+            out << (run ? ", " : "") << result.seconds[run];
+        out << "],\n";
+        out << "      \"median_seconds\": " << result.median << ",\n";
+        out << "      \"mean_seconds\": " << result.mean << ",\n";
+        out << "      \"variance_seconds\": " << result.variance << ",\n";
+        out << "      \"min_seconds\": " << result.min << ",\n";
+        out << "      \"max_seconds\": " << result.max << ",\n";
+        out << "      \"MB_per_second\": " << result.input->bytes / 1e6 / result.median << ",\n";
+        out << "      \"events_per_second\": " << result.input->events / result.median << ",\n";
+        out << "      \"ns_per_event\": " << result.median * 1e9 / std::max(1L, result.input->events) << "\n";
+        out << "    }" << (i + 1 < results.size() ? "," : "") << '\n';
+    }
+    out << "  ]\n";
+    out << "}\n";
+    if (!out) {
+        std::cerr << "xmlbench: Unable to write " << path << '\n';
+        exit(1);
+    }
+}
+
+int main(int argc, char* argv[]) {
+
+    // options
+    int runs = 5;
+    std::size_t size = 8;
+    std::string output = "bench.json";
+    std::string srcfacts = "./srcFacts";
+    std::string xmlstats = "./xmlstats";
+    std::vector<Input> inputs;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--runs" && i + 1 < argc) {
+            runs = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--size" && i + 1 < argc) {
+            size = (std::size_t) std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--output" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg == "--srcfacts" && i + 1 < argc) {
+            srcfacts = argv[++i];
+        } else if (arg == "--xmlstats" && i + 1 < argc) {
+            xmlstats = argv[++i];
+        } else {
+            inputs.push_back({ arg.substr(arg.find_last_of('/') + 1), arg });
+        }
+    }
+    const std::vector<Input> synthetic = generateInputs(size * 1000 * 1000);
+    inputs.insert(inputs.end(), synthetic.begin(), synthetic.end());
+    for (Input& input : inputs) {
+        if (!measureInput(input)) {
+            std::cerr << "xmlbench: Unable to open file " << input.path << '\n';
+            return 1;
+        }
+    }
+
+    const std::vector<Parser> parsers = {
+        { "srcFacts", [&srcfacts] (const Input& input) { return runProgram(srcfacts, input); } },
+        { "xmlstats", [&xmlstats] (const Input& input) { return runProgram(xmlstats, input); } },
+        { "XMLParser", [] (const Input& input) {
+
+            if (!redirectInput(input))
+                return false;
+            long total = 0;
+            XMLParser parser{XMLViewHandlers()};
+            parser.parse(total);
+            return true;
+        } },
+        { "XMLReader", [] (const Input& input) {
+
+            if (!redirectInput(input))
+                return false;
+            XMLReader reader;
+            while (reader.next().kind != XMLTokenKind::End)
+                ;
+            return true;
+        } },
+        { "XMLDocument", [] (const Input& input) {
+
+            if (!redirectInput(input))
+                return false;
+            XMLDocument document;
+            return document.size() != 0;
+        } },
+        { "xml_parser", [] (const Input& input) {
+
+            if (!redirectInput(input))
+                return false;
+            long total = 0;
+            return countXMLEvents(0, total).events() != 0;
+        } },
+    };
+
+    // one untimed run to warm up, then the timed runs
+    std::vector<Result> results;
+    for (const Input& input : inputs) {
+        for (const Parser& parser : parsers) {
+            Result result{ parser.name, &input };
+            bool ok = parser.run(input);
+            for (int run = 0; ok && run < runs; ++run) {
+                const auto start = std::chrono::steady_clock::now();
+                ok = parser.run(input);
+                const auto finish = std::chrono::steady_clock::now();
+                result.seconds.push_back(std::chrono::duration<double>(finish - start).count());
+            }
+            if (!ok) {
+                std::cerr << "xmlbench: " << parser.name << " failed on " << input.path << '\n';
+                return 1;
+            }
+            summarize(result);
+            results.push_back(result);
+        }
+    }
+
+    // Markdown report
+    std::cout << "| Parser | Input | MB/s | events/s | ns/event |\n";
+    std::cout << "|:-------|:------|-----:|---------:|---------:|\n";
+    for (const Result& result : results) {
+        std::cout << "| " << result.parser << " | " << result.input->name
+                  << " | " << (long) (result.input->bytes / 1e6 / result.median)
+                  << " | " << (long) (result.input->events / result.median)
+                  << " | " << result.median * 1e9 / std::max(1L, result.input->events) << " |\n";
+    }
+
+    writeJSON(output, runs, results);
+
+    return 0;
+}
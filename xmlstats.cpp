@@ -4,92 +4,267 @@
     Markdown report with the number of each part of XML.
     E.g., the number of start tags, end tags, attributes,
     character sections, etc.
+
+    Events are only counted, so the handlers take no parameters, and
+    the parser does not produce names, values, or characters.
+
+    Usage: xmlstats [--check] [--stats] [file]
+           xmlstats [-j jobs] [--per-file] [--check] [--stats] name...
+
+    Names are files, quoted globs, directories, or @lists of files. With
+    more than one file, the files are parsed concurrently, each worker
+    reusing one parser, and the report is of all files together, or
+    with --per-file, a row for each file.
+
+    With --check, the input is also checked for well-formedness: end
+    tags match start tags, no duplicate attributes, and valid names.
+    The parser then produces names, so it is slower.
+
+    With --stats, the report is followed by the parse steps by kind,
+    with their counts, time, and bytes. This requires a build with
+    XML_PARSER_STATS.
 */
 
-#include "XMLParser.hpp"
+#include "BasicXMLParser.hpp"
+#include "ThreadPool.hpp"
+#include "inputFiles.hpp"
 #include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <cstdlib>
+#include <fcntl.h>
 
-int main() {
+#if !defined(_MSC_VER)
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
 
-    long total = 0;
-    int decl_count = 0;
-    int start_tag_count = 0;
-    int end_tag_count = 0;
-    int character_count = 0;
-    int attribute_count = 0;
-    int namespace_count = 0;
-    int comment_count = 0;
-    int CDATA_count = 0;
-    std::string local_name;
-    std::string value;
-    std::string characters;
+// XML counts from XML events
+class xmlstatsHandler {
+public:
+
+    // count xml declerations
+    void handleDeclaration() {
+
+        ++decl_count;
+    }
+
+    // count Start Tag
+    void handleStartTag() {
+
+        ++start_tag_count;
+    }
+
+    // count End Tag
+    void handleEndTag() {
+
+        ++end_tag_count;
+    }
+
+    // count Attribute
+    void handleAttribute() {
+
+        ++attribute_count;
+    }
+
+    // count namespaces
+    void handleNamespace() {
+
+        ++namespace_count;
+    }
+
+    // count CDATA
+    void handleCDATA() {
+
+        ++CDATA_count;
+    }
+
+    // count characters
+    void handleCharacters() {
+
+        ++character_count;
+    }
 
-    XMLParser parser(
+    // count commments
+    void handleComments() {
 
-        // count xml declerations
-        [&decl_count](const std::string& value, const std::string& encoding, const std::string& standalon) {
+        ++comment_count;
+    }
 
-            ++decl_count;
-        },
+    // add the counts of another input
+    xmlstatsHandler& operator+=(const xmlstatsHandler& other) {
 
-        // count Start Tag
-        [&start_tag_count](const std::string& local_name, const std::string& prefix) {
+        decl_count += other.decl_count;
+        start_tag_count += other.start_tag_count;
+        end_tag_count += other.end_tag_count;
+        character_count += other.character_count;
+        attribute_count += other.attribute_count;
+        namespace_count += other.namespace_count;
+        comment_count += other.comment_count;
+        CDATA_count += other.CDATA_count;
 
-            ++start_tag_count;
-        },
+        return *this;
+    }
 
-        // count End Tag
-        [&end_tag_count](const std::string& local_name, const std::string& prefix) {
+    long decl_count = 0;
+    long start_tag_count = 0;
+    long end_tag_count = 0;
+    long character_count = 0;
+    long attribute_count = 0;
+    long namespace_count = 0;
+    long comment_count = 0;
+    long CDATA_count = 0;
+};
 
-            ++end_tag_count;
-        },
+// XML report
+static void report(const xmlstatsHandler& stats) {
 
-        // ount Attribute
-        [&attribute_count](const std::string& local_name, const std::string& value) {
+    std::cout << "| Item | Count |\n";
+    std::cout << "|:-----|------:|\n";
+    std::cout << "| XML declerations | " << stats.decl_count << " |\n";
+    std::cout << "| start tags | " << stats.start_tag_count << " |\n";
+    std::cout << "| end tags | " << stats.end_tag_count << " |\n";
+    std::cout << "| character sections | " << stats.character_count << " |\n";
+    std::cout << "| attributes | " << stats.attribute_count << " |\n";
+    std::cout << "| namespaces | " << stats.namespace_count << " |\n";
+    std::cout << "| comments | " << stats.comment_count << " |\n";
+    std::cout << "| CDATA | " << stats.CDATA_count << " |\n";
+}
+
+// XML report with a row for each file
+static void reportFiles(const std::vector<std::string>& files, const std::vector<xmlstatsHandler>& results) {
+
+    std::cout << "| File | XML declerations | start tags | end tags | character sections | attributes | namespaces | comments | CDATA |\n";
+    std::cout << "|:-----|------:|------:|------:|------:|------:|------:|------:|------:|\n";
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        const xmlstatsHandler& stats = results[i];
+        std::cout << "| " << files[i] << " | " << stats.decl_count << " | " << stats.start_tag_count
+                  << " | " << stats.end_tag_count << " | " << stats.character_count << " | " << stats.attribute_count
+                  << " | " << stats.namespace_count << " | " << stats.comment_count << " | " << stats.CDATA_count << " |\n";
+    }
+}
+
+// count each file concurrently, with one parser for each worker
+// @return false if a file could not be opened
+static bool batchStats(const std::vector<std::string>& files, int jobs, bool check, std::vector<xmlstatsHandler>& results, XMLParserStats& stats) {
+
+    ThreadPool pool(jobs);
+    struct Worker {
+        xmlstatsHandler stats;
+        BasicXMLParser<xmlstatsHandler> parser{stats};
+    };
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < pool.size(); ++i) {
+        workers.push_back(std::make_unique<Worker>());
+        workers.back()->parser.checkWellFormed(check);
+    }
+
+    results.assign(files.size(), xmlstatsHandler());
+    std::vector<char> failed(files.size(), false);
+    pool.run(files.size(), [&](std::size_t index, int worker) {
+
+        const int fd = open(files[index].c_str(), O_RDONLY);
+        if (fd == -1) {
+            failed[index] = true;
+            return;
+        }
+        Worker& current = *workers[worker];
+        current.stats = xmlstatsHandler();
+        long total = 0;
+        current.parser.parse(fd, total);
+        close(fd);
+        results[index] = current.stats;
+    });
+
+    for (const auto& current : workers)
+        stats += current->parser.stats();
 
-            ++attribute_count;
-        },
+    bool ok = true;
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        if (failed[i]) {
+            std::cerr << "xmlstats: Unable to open file " << files[i] << '\n';
+            ok = false;
+        }
+    }
+
+    return ok;
+}
 
-        // count namespaces
-        [&namespace_count](const std::string& uri, const std::string& a) {
-            ++namespace_count;
-        },
+int main(int argc, char* argv[]) {
 
-        // count CDATA
-        [&CDATA_count](const std::string& local_name, const long& total) {
+    // options
+    int jobs = 0;
+    bool perFile = false;
+    bool showStats = false;
+    bool check = false;
+    std::vector<std::string> names;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            jobs = std::atoi(argv[++i]);
+        } else if (std::strncmp(argv[i], "--jobs=", strlen("--jobs=")) == 0) {
+            jobs = std::atoi(argv[i] + strlen("--jobs="));
+        } else if (std::strcmp(argv[i], "--per-file") == 0) {
+            perFile = true;
+        } else if (std::strcmp(argv[i], "--stats") == 0) {
+            showStats = true;
+        } else if (std::strcmp(argv[i], "--check") == 0) {
+            check = true;
+        } else {
+            names.push_back(argv[i]);
+        }
+    }
 
-            ++CDATA_count;
-        },
+    if (showStats && !XMLParserStats::enabled) {
+        std::cerr << "xmlstats: --stats requires a build with XML_PARSER_STATS\n";
+        return 1;
+    }
+    XMLParserStats stats;
 
-        // Entity, unneeded
-        nullptr,
+    // batch of files
+    const std::vector<std::string> files = expandInputs(names);
+    if (files.size() > 1 || perFile) {
+        std::vector<xmlstatsHandler> results;
+        if (!batchStats(files, jobs, check, results, stats))
+            return 1;
+        if (perFile) {
+            reportFiles(files, results);
+        } else {
+            xmlstatsHandler totals;
+            for (const auto& result : results)
+                totals += result;
+            report(totals);
+        }
+        if (showStats)
+            stats.report(std::cout);
 
-        // count characters
-        [&character_count](const std::string& characters, const char& c) {
+        return 0;
+    }
 
-            ++character_count;
-        },
+    long total = 0;
+    xmlstatsHandler counts;
+    BasicXMLParser<xmlstatsHandler> parser(counts);
+    parser.checkWellFormed(check);
 
-        // count commments
-        [&comment_count]() {
-            ++comment_count;
+    // input is the named file, or standard input
+    int fd = 0;
+    if (!files.empty()) {
+        fd = open(files[0].c_str(), O_RDONLY);
+        if (fd == -1) {
+            std::cerr << "xmlstats: Unable to open file " << files[0] << '\n';
+            return 1;
         }
-    );
+    }
 
     // parse XML
-    parser.parse(total, characters, value, local_name);
+    parser.parse(fd, total);
 
     // XML Report
-    std::cout << "| Item | Count |\n";
-    std::cout << "|:-----|------:|\n";
-    std::cout << "| XML declerations | " << decl_count << " |\n";
-    std::cout << "| start tags | " << start_tag_count << " |\n";
-    std::cout << "| end tags | " << end_tag_count << " |\n";
-    std::cout << "| character sections | " << character_count << " |\n";
-    std::cout << "| attributes | " << attribute_count << " |\n";
-    std::cout << "| namespaces | " << namespace_count << " |\n";
-    std::cout << "| comments | " << comment_count << " |\n";
-    std::cout << "| CDATA | " << CDATA_count << " |\n";
+    report(counts);
+    if (showStats)
+        parser.stats().report(std::cout);
 
     return 0;
 }